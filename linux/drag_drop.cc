@@ -0,0 +1,545 @@
+#include "drag_drop.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+constexpr char kChannelName[] = "function_window_drag/drag_drop";
+
+// Largest chunk returned by a single "read" call, which bounds the memory a
+// transfer can pin at once.
+constexpr gsize kMaxChunkSize = 4 * 1024 * 1024;
+
+enum DragTarget {
+  kTargetUriList,
+};
+
+const GtkTargetEntry kTargets[] = {
+    {const_cast<gchar*>("text/uri-list"), 0, kTargetUriList},
+};
+
+// A dropped local file. Reads copy chunks out with pread(), so a file
+// truncated after the drop just yields a short chunk. The file is only
+// mapped once drag_drop_map_item() asks for zero-copy access.
+//
+// Items are reference counted so reads can run without holding the
+// handler's lock: releasing an item while a read is in flight only closes
+// the file once the read is done.
+struct DropItem {
+  gint ref_count;
+  int fd;
+  // Size when the file was dropped.
+  gsize size;
+  // Contents mapped for FFI, nullptr until requested. |mapped_size| is the
+  // file size at mapping time.
+  guint8* data;
+  gsize mapped_size;
+};
+
+DropItem* drop_item_ref(DropItem* item) {
+  g_atomic_int_inc(&item->ref_count);
+  return item;
+}
+
+void drop_item_unref(gpointer data) {
+  DropItem* item = static_cast<DropItem*>(data);
+  if (!g_atomic_int_dec_and_test(&item->ref_count)) {
+    return;
+  }
+  if (item->data != nullptr) {
+    munmap(item->data, item->mapped_size);
+  }
+  close(item->fd);
+  delete item;
+}
+
+// Arguments of a "read" call, handed to the worker thread.
+struct ReadRequest {
+  int64_t id;
+  uint64_t offset;
+  uint64_t length;
+};
+
+}  // namespace
+
+struct _DragDrop {
+  GObject parent_instance;
+
+  // Window accepting drops (weak reference).
+  GtkWindow* window;
+
+  FlMethodChannel* channel;
+
+  // Maps item ids to DropItem. Guarded by |lock| as reads run on worker
+  // threads and FFI calls come from Dart's threads.
+  GMutex lock;
+  GHashTable* items;
+  int64_t next_item_id;
+
+  // Paths offered by the drag started from Dart, or nullptr.
+  gchar** drag_uris;
+};
+
+G_DEFINE_TYPE(DragDrop, drag_drop, G_TYPE_OBJECT)
+
+G_DEFINE_QUARK(drag-drop-error-quark, drag_drop_error)
+
+// The handler exposed through FFI, as Dart has no handle to pass in. Only
+// read or written with |ffi_lock| held, so FFI calls never see a handler
+// that is being disposed.
+static DragDrop* ffi_drag_drop = nullptr;
+static GMutex ffi_lock;
+
+// Opens |path|. Returns nullptr if it is not a readable regular file.
+static DropItem* drop_item_open(const gchar* path) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+    close(fd);
+    return nullptr;
+  }
+
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  return new DropItem{1, fd, static_cast<gsize>(info.st_size), nullptr, 0};
+}
+
+// Returns a new reference to item |id|, or nullptr if there is none.
+static DropItem* drag_drop_lookup(DragDrop* self, int64_t id) {
+  g_mutex_lock(&self->lock);
+  DropItem* item = self->items != nullptr
+                       ? static_cast<DropItem*>(
+                             g_hash_table_lookup(self->items, &id))
+                       : nullptr;
+  if (item != nullptr) {
+    drop_item_ref(item);
+  }
+  g_mutex_unlock(&self->lock);
+  return item;
+}
+
+// Reads up to |count| bytes at |offset| into |buffer|, stopping early at the
+// current end of the file. Returns the number of bytes read, or -1.
+static gssize drop_item_read(DropItem* item, guint8* buffer, gsize offset,
+                             gsize count) {
+  gsize total = 0;
+  while (total < count) {
+    ssize_t result = pread(item->fd, buffer + total, count - total,
+                           static_cast<off_t>(offset + total));
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result < 0) {
+      return -1;
+    }
+    if (result == 0) {
+      break;
+    }
+    total += result;
+  }
+  return total;
+}
+
+// Maps |item| for zero-copy access if not done yet. Empty files map to
+// nullptr with a size of 0.
+static gboolean drop_item_map(DropItem* item) {
+  if (item->data != nullptr) {
+    return TRUE;
+  }
+  struct stat info;
+  if (fstat(item->fd, &info) != 0) {
+    return FALSE;
+  }
+  item->mapped_size = info.st_size;
+  if (item->mapped_size == 0) {
+    return TRUE;
+  }
+  void* data =
+      mmap(nullptr, item->mapped_size, PROT_READ, MAP_PRIVATE, item->fd, 0);
+  if (data == MAP_FAILED) {
+    item->mapped_size = 0;
+    return FALSE;
+  }
+  item->data = static_cast<guint8*>(data);
+  madvise(item->data, item->mapped_size, MADV_SEQUENTIAL);
+  return TRUE;
+}
+
+static void drag_data_received_cb(GtkWidget* widget, GdkDragContext* context,
+                                  gint x, gint y, GtkSelectionData* data,
+                                  guint info, guint time, gpointer user_data) {
+  DragDrop* self = DRAG_DROP(user_data);
+  if (info != kTargetUriList) {
+    return;
+  }
+  g_auto(GStrv) uris = gtk_selection_data_get_uris(data);
+  if (uris == nullptr) {
+    return;
+  }
+
+  g_autoptr(FlValue) dropped = fl_value_new_list();
+  for (gchar** uri = uris; *uri != nullptr; uri++) {
+    g_autofree gchar* path = g_filename_from_uri(*uri, nullptr, nullptr);
+    if (path == nullptr) {
+      continue;
+    }
+    uint64_t size = 0;
+    int64_t id = drag_drop_add_file(self, path, &size);
+    if (id < 0) {
+      g_warning("Ignoring dropped item %s: not a readable file", path);
+      continue;
+    }
+
+    FlValue* entry = fl_value_new_map();
+    fl_value_set_string_take(entry, "id", fl_value_new_int(id));
+    fl_value_set_string_take(entry, "path", fl_value_new_string(path));
+    fl_value_set_string_take(entry, "size", fl_value_new_int(size));
+    fl_value_append_take(dropped, entry);
+  }
+
+  if (fl_value_get_length(dropped) > 0 && self->channel != nullptr) {
+    fl_method_channel_invoke_method(self->channel, "onDrop", dropped, nullptr,
+                                    nullptr, nullptr);
+  }
+}
+
+static void drag_data_get_cb(GtkWidget* widget, GdkDragContext* context,
+                             GtkSelectionData* data, guint info, guint time,
+                             gpointer user_data) {
+  DragDrop* self = DRAG_DROP(user_data);
+  if (info == kTargetUriList && self->drag_uris != nullptr) {
+    gtk_selection_data_set_uris(data, self->drag_uris);
+  }
+}
+
+static void drag_end_cb(GtkWidget* widget, GdkDragContext* context,
+                        gpointer user_data) {
+  DragDrop* self = DRAG_DROP(user_data);
+  g_clear_pointer(&self->drag_uris, g_strfreev);
+}
+
+static void read_request_free(gpointer data) {
+  delete static_cast<ReadRequest*>(data);
+}
+
+// Runs drag_drop_read_chunk() on a GTask worker thread.
+static void read_thread_func(GTask* task, gpointer source_object,
+                             gpointer task_data, GCancellable* cancellable) {
+  ReadRequest* request = static_cast<ReadRequest*>(task_data);
+  GError* error = nullptr;
+  FlValue* chunk =
+      drag_drop_read_chunk(DRAG_DROP(source_object), request->id,
+                           request->offset, request->length, &error);
+  if (chunk == nullptr) {
+    g_task_return_error(task, error);
+  } else {
+    g_task_return_pointer(task, chunk,
+                          reinterpret_cast<GDestroyNotify>(fl_value_unref));
+  }
+}
+
+// Responds to a "read" call once its worker is done.
+static void read_done_cb(GObject* object, GAsyncResult* result,
+                         gpointer user_data) {
+  g_autoptr(FlMethodCall) method_call = FL_METHOD_CALL(user_data);
+  g_autoptr(GError) error = nullptr;
+  g_autoptr(FlValue) chunk =
+      static_cast<FlValue*>(g_task_propagate_pointer(G_TASK(result), &error));
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (chunk == nullptr) {
+    response = FL_METHOD_RESPONSE(fl_method_error_response_new(
+        error->code == DRAG_DROP_ERROR_NOT_FOUND ? "not_found" : "io_error",
+        error->message, nullptr));
+  } else {
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(chunk));
+  }
+  g_autoptr(GError) respond_error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &respond_error)) {
+    g_warning("Failed to send drag and drop response: %s",
+              respond_error->message);
+  }
+}
+
+// Starts a "read" call. The chunk is read on a worker thread, as a cold file
+// on a slow disk would otherwise stall the GTK thread between frames, and
+// the call is answered from read_done_cb(). Returns an error response for
+// bad arguments, or nullptr once the read is under way.
+static FlMethodResponse* drag_drop_read(DragDrop* self,
+                                        FlMethodCall* method_call,
+                                        FlValue* args) {
+  FlValue* id = nullptr;
+  FlValue* offset = nullptr;
+  FlValue* length = nullptr;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    id = fl_value_lookup_string(args, "id");
+    offset = fl_value_lookup_string(args, "offset");
+    length = fl_value_lookup_string(args, "length");
+  }
+  if (id == nullptr || fl_value_get_type(id) != FL_VALUE_TYPE_INT ||
+      offset == nullptr || fl_value_get_type(offset) != FL_VALUE_TYPE_INT ||
+      length == nullptr || fl_value_get_type(length) != FL_VALUE_TYPE_INT ||
+      fl_value_get_int(offset) < 0 || fl_value_get_int(length) < 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad_args", "Expected int id, offset and length", nullptr));
+  }
+
+  ReadRequest* request =
+      new ReadRequest{fl_value_get_int(id),
+                      static_cast<uint64_t>(fl_value_get_int(offset)),
+                      static_cast<uint64_t>(fl_value_get_int(length))};
+  g_autoptr(GTask) task = g_task_new(self, nullptr, read_done_cb,
+                                     g_object_ref(method_call));
+  g_task_set_task_data(task, request, read_request_free);
+  g_task_run_in_thread(task, read_thread_func);
+  return nullptr;
+}
+
+static FlMethodResponse* drag_drop_release(DragDrop* self, FlValue* args) {
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_INT) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad_args", "Expected an int item id", nullptr));
+  }
+  int64_t item_id = fl_value_get_int(args);
+  g_mutex_lock(&self->lock);
+  g_hash_table_remove(self->items, &item_id);
+  g_mutex_unlock(&self->lock);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+static FlMethodResponse* drag_drop_start_drag(DragDrop* self, FlValue* args) {
+  if (self->window == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "no_window", "The application window is gone", nullptr));
+  }
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_LIST ||
+      fl_value_get_length(args) == 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad_args", "Expected a non-empty list of file paths", nullptr));
+  }
+
+  size_t length = fl_value_get_length(args);
+  g_auto(GStrv) uris = g_new0(gchar*, length + 1);
+  for (size_t i = 0; i < length; i++) {
+    FlValue* path = fl_value_get_list_value(args, i);
+    if (fl_value_get_type(path) != FL_VALUE_TYPE_STRING) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          "bad_args", "Expected a non-empty list of file paths", nullptr));
+    }
+    uris[i] = g_filename_to_uri(fl_value_get_string(path), nullptr, nullptr);
+    if (uris[i] == nullptr) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          "bad_args", "File paths must be absolute", nullptr));
+    }
+  }
+
+  GtkTargetList* targets =
+      gtk_target_list_new(kTargets, G_N_ELEMENTS(kTargets));
+  GdkDragContext* context = gtk_drag_begin_with_coordinates(
+      GTK_WIDGET(self->window), targets, GDK_ACTION_COPY, 1, nullptr, -1, -1);
+  gtk_target_list_unref(targets);
+  if (context == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "drag_failed", "Unable to start the drag", nullptr));
+  }
+  g_strfreev(self->drag_uris);
+  self->drag_uris = static_cast<gchar**>(g_steal_pointer(&uris));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+static void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
+                           gpointer user_data) {
+  DragDrop* self = DRAG_DROP(user_data);
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "read") == 0) {
+    response = drag_drop_read(self, method_call, args);
+    if (response == nullptr) {
+      return;
+    }
+  } else if (strcmp(method, "release") == 0) {
+    response = drag_drop_release(self, args);
+  } else if (strcmp(method, "startDrag") == 0) {
+    response = drag_drop_start_drag(self, args);
+  } else {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error)) {
+    g_warning("Failed to send drag and drop response: %s", error->message);
+  }
+}
+
+// Implements GObject::dispose.
+static void drag_drop_dispose(GObject* object) {
+  DragDrop* self = DRAG_DROP(object);
+
+  g_mutex_lock(&ffi_lock);
+  if (ffi_drag_drop == self) {
+    ffi_drag_drop = nullptr;
+  }
+  g_mutex_unlock(&ffi_lock);
+  if (self->window != nullptr) {
+    g_signal_handlers_disconnect_by_data(self->window, self);
+    gtk_drag_dest_unset(GTK_WIDGET(self->window));
+    g_object_remove_weak_pointer(G_OBJECT(self->window),
+                                 reinterpret_cast<gpointer*>(&self->window));
+    self->window = nullptr;
+  }
+  g_clear_object(&self->channel);
+  g_clear_pointer(&self->drag_uris, g_strfreev);
+  g_mutex_lock(&self->lock);
+  g_clear_pointer(&self->items, g_hash_table_unref);
+  g_mutex_unlock(&self->lock);
+
+  G_OBJECT_CLASS(drag_drop_parent_class)->dispose(object);
+}
+
+// Implements GObject::finalize.
+static void drag_drop_finalize(GObject* object) {
+  DragDrop* self = DRAG_DROP(object);
+  g_mutex_clear(&self->lock);
+  G_OBJECT_CLASS(drag_drop_parent_class)->finalize(object);
+}
+
+static void drag_drop_class_init(DragDropClass* klass) {
+  G_OBJECT_CLASS(klass)->dispose = drag_drop_dispose;
+  G_OBJECT_CLASS(klass)->finalize = drag_drop_finalize;
+}
+
+static void drag_drop_init(DragDrop* self) {
+  g_mutex_init(&self->lock);
+  self->items = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free,
+                                      drop_item_unref);
+  self->next_item_id = 1;
+}
+
+static void drag_drop_set_ffi(DragDrop* self) {
+  g_mutex_lock(&ffi_lock);
+  ffi_drag_drop = self;
+  g_mutex_unlock(&ffi_lock);
+}
+
+DragDrop* drag_drop_new(GtkWindow* window, FlBinaryMessenger* messenger) {
+  DragDrop* self = DRAG_DROP(g_object_new(drag_drop_get_type(), nullptr));
+
+  if (window == nullptr) {
+    drag_drop_set_ffi(self);
+    return self;
+  }
+  self->window = window;
+  g_object_add_weak_pointer(G_OBJECT(window),
+                            reinterpret_cast<gpointer*>(&self->window));
+  gtk_drag_dest_set(GTK_WIDGET(window), GTK_DEST_DEFAULT_ALL, kTargets,
+                    G_N_ELEMENTS(kTargets), GDK_ACTION_COPY);
+  g_signal_connect(window, "drag-data-received",
+                   G_CALLBACK(drag_data_received_cb), self);
+  g_signal_connect(window, "drag-data-get", G_CALLBACK(drag_data_get_cb), self);
+  g_signal_connect(window, "drag-end", G_CALLBACK(drag_end_cb), self);
+
+  if (messenger == nullptr) {
+    drag_drop_set_ffi(self);
+    return self;
+  }
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  self->channel = fl_method_channel_new(messenger, kChannelName,
+                                        FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(self->channel, method_call_cb,
+                                            self, nullptr);
+
+  drag_drop_set_ffi(self);
+  return self;
+}
+
+int64_t drag_drop_add_file(DragDrop* self, const gchar* path,
+                           uint64_t* size) {
+  g_return_val_if_fail(DRAG_IS_DROP(self), -1);
+
+  DropItem* item = drop_item_open(path);
+  if (item == nullptr) {
+    return -1;
+  }
+  if (size != nullptr) {
+    *size = item->size;
+  }
+  g_mutex_lock(&self->lock);
+  int64_t id = self->next_item_id++;
+  int64_t* key = g_new(int64_t, 1);
+  *key = id;
+  g_hash_table_insert(self->items, key, item);
+  g_mutex_unlock(&self->lock);
+  return id;
+}
+
+FlValue* drag_drop_read_chunk(DragDrop* self, int64_t id, uint64_t offset,
+                              uint64_t length, GError** error) {
+  g_return_val_if_fail(DRAG_IS_DROP(self), nullptr);
+
+  DropItem* item = drag_drop_lookup(self, id);
+  if (item == nullptr) {
+    g_set_error(error, DRAG_DROP_ERROR, DRAG_DROP_ERROR_NOT_FOUND,
+                "Unknown or released drop item");
+    return nullptr;
+  }
+
+  gsize start = MIN(offset, item->size);
+  gsize count = MIN(MIN(length, kMaxChunkSize), item->size - start);
+  g_autofree guint8* buffer = static_cast<guint8*>(g_malloc(count));
+  gssize n_read = drop_item_read(item, buffer, start, count);
+  int saved_errno = errno;
+  drop_item_unref(item);
+  if (n_read < 0) {
+    g_set_error(error, DRAG_DROP_ERROR, DRAG_DROP_ERROR_IO,
+                "Failed to read drop item: %s", g_strerror(saved_errno));
+    return nullptr;
+  }
+  return fl_value_new_uint8_list(buffer, n_read);
+}
+
+gboolean drag_drop_map_item(int64_t id, const uint8_t** data, uint64_t* size) {
+  g_mutex_lock(&ffi_lock);
+  DragDrop* self = ffi_drag_drop;
+  gboolean mapped = FALSE;
+  if (self != nullptr) {
+    g_mutex_lock(&self->lock);
+    DropItem* item = self->items != nullptr
+                         ? static_cast<DropItem*>(
+                               g_hash_table_lookup(self->items, &id))
+                         : nullptr;
+    mapped = item != nullptr && drop_item_map(item);
+    if (mapped) {
+      *data = item->data;
+      *size = item->mapped_size;
+    }
+    g_mutex_unlock(&self->lock);
+  }
+  g_mutex_unlock(&ffi_lock);
+  return mapped;
+}
+
+int64_t drag_drop_read_into(int64_t id, uint64_t offset, uint8_t* buffer,
+                            uint64_t length) {
+  g_mutex_lock(&ffi_lock);
+  DropItem* item =
+      ffi_drag_drop != nullptr ? drag_drop_lookup(ffi_drag_drop, id) : nullptr;
+  g_mutex_unlock(&ffi_lock);
+  if (item == nullptr) {
+    return -1;
+  }
+  gsize start = MIN(offset, item->size);
+  gssize n_read =
+      drop_item_read(item, buffer, start, MIN(length, item->size - start));
+  drop_item_unref(item);
+  return n_read;
+}
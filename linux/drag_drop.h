@@ -0,0 +1,114 @@
+#ifndef FLUTTER_DRAG_DROP_H_
+#define FLUTTER_DRAG_DROP_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <gmodule.h>
+#include <gtk/gtk.h>
+
+#include <stdint.h>
+
+G_DECLARE_FINAL_TYPE(DragDrop, drag_drop, DRAG, DROP, GObject)
+
+#define DRAG_DROP_ERROR drag_drop_error_quark()
+
+typedef enum {
+  DRAG_DROP_ERROR_NOT_FOUND,
+  DRAG_DROP_ERROR_IO,
+} DragDropError;
+
+GQuark drag_drop_error_quark();
+
+/**
+ * drag_drop_new:
+ * @window: (allow-none): the #GtkWindow that accepts drops and starts
+ *   drags, or %NULL to only serve files added with drag_drop_add_file().
+ * @messenger: (allow-none): the #FlBinaryMessenger used for the "drag_drop"
+ *   channel, or %NULL to only drive the handler from native code.
+ *
+ * Creates a drag-and-drop handler that never buffers whole payloads. Drops
+ * are accepted as `text/uri-list`; each local file is opened and handed to
+ * Dart as a lazy item that is read in chunks or accessed directly through
+ * drag_drop_map_item(). Drags started from Dart offer file URIs, so
+ * the receiving application reads the data straight from disk.
+ *
+ * Returns: a new #DragDrop.
+ */
+DragDrop* drag_drop_new(GtkWindow* window, FlBinaryMessenger* messenger);
+
+/**
+ * drag_drop_add_file:
+ * @drag_drop: a #DragDrop.
+ * @path: path of a local file.
+ * @size: (out) (allow-none): location for the size of the file.
+ *
+ * Adds @path as a dropped item, as a drop onto the window does.
+ *
+ * Returns: the id of the new item, or -1 if @path is not a readable regular
+ * file.
+ */
+int64_t drag_drop_add_file(DragDrop* drag_drop, const gchar* path,
+                           uint64_t* size);
+
+/**
+ * drag_drop_read_chunk:
+ * @drag_drop: a #DragDrop.
+ * @id: id of a dropped item.
+ * @offset: offset of the chunk in bytes.
+ * @length: requested length; chunks are capped at 4 MiB.
+ * @error: (allow-none): #GError location to store the error occurring, or
+ *   %NULL to ignore.
+ *
+ * Reads a chunk of a dropped item, as the "read" method of the "drag_drop"
+ * channel does on a worker thread. The chunk is short at the end of the
+ * file, including when the file shrank after the drop. Blocks on disk I/O;
+ * may be called from any thread.
+ *
+ * Returns: (transfer full): a #FlValue of type %FL_VALUE_TYPE_UINT8_LIST, or
+ * %NULL on error.
+ */
+FlValue* drag_drop_read_chunk(DragDrop* drag_drop, int64_t id, uint64_t offset,
+                              uint64_t length, GError** error);
+
+G_BEGIN_DECLS
+
+/**
+ * drag_drop_map_item:
+ * @id: id of a dropped item as reported to Dart.
+ * @data: (out): location for the start of the mapped contents.
+ * @size: (out): location for the size of the contents in bytes.
+ *
+ * FFI entry point giving zero-copy access to a dropped file, which is
+ * mapped on the first call. The mapping stays valid until Dart releases the
+ * item.
+ *
+ * The file is shared with other processes: if it is truncated while
+ * mapped, touching pages past its new end raises SIGBUS and kills the
+ * application. Only use this for files that are known not to change, and
+ * the "read" method otherwise.
+ *
+ * Returns: %TRUE if @id names a live item.
+ */
+G_MODULE_EXPORT gboolean drag_drop_map_item(int64_t id, const uint8_t** data,
+                                            uint64_t* size);
+
+/**
+ * drag_drop_read_into:
+ * @id: id of a dropped item as reported to Dart.
+ * @offset: offset in bytes to read from.
+ * @buffer: destination of at least @length bytes.
+ * @length: number of bytes to read.
+ *
+ * FFI entry point reading a dropped file straight into a buffer owned by
+ * Dart, with no intermediate copy and no 4 MiB cap. It blocks on disk I/O,
+ * so call it off the Dart UI thread, e.g. from a helper isolate. Unlike
+ * drag_drop_map_item(), a file truncated meanwhile just yields a short read.
+ *
+ * Returns: the number of bytes read, short at the end of the file, or -1 if
+ * @id is not a live item or reading failed.
+ */
+G_MODULE_EXPORT int64_t drag_drop_read_into(int64_t id, uint64_t offset,
+                                            uint8_t* buffer, uint64_t length);
+
+G_END_DECLS
+
+#endif  // FLUTTER_DRAG_DROP_H_
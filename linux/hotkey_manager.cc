@@ -0,0 +1,580 @@
+#include "hotkey_manager.h"
+
+#include <gdk/gdkx.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr char kChannelName[] = "function_window_drag/hotkeys";
+
+// How long a partially typed chord stays armed before it is abandoned.
+constexpr guint kChordTimeoutMs = 1000;
+
+// Longest chord accepted by "bind", e.g. "<Super>w 1" has two steps.
+constexpr guint kMaxChordSteps = 4;
+
+// Modifiers that take part in matching. Lock modifiers (Caps Lock, Num Lock)
+// are ignored so hotkeys keep working whatever their state.
+constexpr unsigned int kMatchedModifiers =
+    ShiftMask | ControlMask | Mod1Mask | Mod4Mask;
+constexpr unsigned int kIgnoredModifiers[] = {0, LockMask, Mod2Mask,
+                                              LockMask | Mod2Mask};
+
+enum class HotkeyAction {
+  kNotify,
+  kMinimize,
+  kToggleMaximize,
+  kClose,
+  kPresent,
+};
+
+struct ChordStep {
+  KeySym keysym;
+  unsigned int modifiers;
+};
+
+struct Binding {
+  int64_t id;
+  std::vector<ChordStep> steps;
+  HotkeyAction action;
+  // FALSE while a key of the chord has no keycode in the current keyboard
+  // layout; the binding comes back once a layout maps it again.
+  bool active;
+};
+
+enum class TrieInsertResult {
+  kInserted,
+  // A key of the chord has no keycode in the current keyboard layout.
+  kUnmapped,
+  // The chord is a prefix of an existing one, or the other way round.
+  kConflict,
+};
+
+// A node of the chord trie. Node 0 is the root; children form a sibling
+// list, so matching a key press is a short scan with no allocation.
+struct TrieNode {
+  KeyCode keycode;
+  unsigned int modifiers;
+  int first_child;
+  int next_sibling;
+  // Id of the binding completed at this node, or -1 for a chord prefix.
+  int64_t binding_id;
+  HotkeyAction action;
+};
+
+}  // namespace
+
+struct _HotkeyManager {
+  GObject parent_instance;
+
+  // Window that bound actions operate on (weak reference).
+  GtkWindow* window;
+
+  FlMethodChannel* channel;
+
+  // X11 connection, or nullptr when not running on X11.
+  GdkDisplay* display;
+  Display* xdisplay;
+  Window root;
+
+  // Bindings are the source of truth; the trie is rebuilt from them whenever
+  // they change or the keyboard mapping changes.
+  std::vector<Binding>* bindings;
+  std::vector<TrieNode>* trie;
+
+  // Trie node reached by the keys typed so far in the current chord, and the
+  // modifiers of the step that reached it.
+  int state;
+  unsigned int state_modifiers;
+  gboolean keyboard_grabbed;
+  guint chord_timeout_id;
+};
+
+G_DEFINE_TYPE(HotkeyManager, hotkey_manager, G_TYPE_OBJECT)
+
+enum {
+  SIGNAL_ACTIVATED,
+  N_SIGNALS,
+};
+
+static guint signals[N_SIGNALS];
+
+G_DEFINE_QUARK(hotkey-manager-error-quark, hotkey_manager_error)
+
+// Converts GDK modifiers from gtk_accelerator_parse() to X11 modifier bits.
+static unsigned int x11_modifiers(GdkModifierType modifiers) {
+  unsigned int result = 0;
+  if (modifiers & GDK_SHIFT_MASK) {
+    result |= ShiftMask;
+  }
+  if (modifiers & GDK_CONTROL_MASK) {
+    result |= ControlMask;
+  }
+  if (modifiers & GDK_MOD1_MASK) {
+    result |= Mod1Mask;
+  }
+  if (modifiers & (GDK_SUPER_MASK | GDK_MOD4_MASK)) {
+    result |= Mod4Mask;
+  }
+  return result;
+}
+
+static gboolean parse_action(const gchar* name, HotkeyAction* action) {
+  if (name == nullptr || strcmp(name, "notify") == 0) {
+    *action = HotkeyAction::kNotify;
+  } else if (strcmp(name, "minimize") == 0) {
+    *action = HotkeyAction::kMinimize;
+  } else if (strcmp(name, "toggleMaximize") == 0) {
+    *action = HotkeyAction::kToggleMaximize;
+  } else if (strcmp(name, "close") == 0) {
+    *action = HotkeyAction::kClose;
+  } else if (strcmp(name, "present") == 0) {
+    *action = HotkeyAction::kPresent;
+  } else {
+    return FALSE;
+  }
+  return TRUE;
+}
+
+// Parses a space separated chord such as "<Super>w 1" into |steps|.
+static gboolean parse_chord(const gchar* chord, std::vector<ChordStep>* steps) {
+  g_auto(GStrv) tokens = g_strsplit_set(chord, " \t", -1);
+  for (gchar** token = tokens; *token != nullptr; token++) {
+    if (**token == '\0') {
+      continue;
+    }
+    guint keyval = 0;
+    GdkModifierType modifiers = static_cast<GdkModifierType>(0);
+    gtk_accelerator_parse(*token, &keyval, &modifiers);
+    if (keyval == 0 || steps->size() == kMaxChordSteps) {
+      return FALSE;
+    }
+    // GDK keyvals share their values with X11 keysyms.
+    steps->push_back({static_cast<KeySym>(keyval), x11_modifiers(modifiers)});
+  }
+  return !steps->empty();
+}
+
+static int trie_find_child(const std::vector<TrieNode>& trie, int parent,
+                           KeyCode keycode, unsigned int modifiers) {
+  for (int child = trie[parent].first_child; child >= 0;
+       child = trie[child].next_sibling) {
+    if (trie[child].keycode == keycode && trie[child].modifiers == modifiers) {
+      return child;
+    }
+  }
+  return -1;
+}
+
+// Adds |binding| to |trie|. |trie| is left unchanged unless the binding is
+// inserted: keycodes are resolved before any node is added, and a conflict
+// can only be found along existing nodes.
+static TrieInsertResult trie_insert(Display* xdisplay,
+                                    std::vector<TrieNode>* trie,
+                                    const Binding& binding) {
+  KeyCode keycodes[kMaxChordSteps];
+  for (size_t i = 0; i < binding.steps.size(); i++) {
+    keycodes[i] = XKeysymToKeycode(xdisplay, binding.steps[i].keysym);
+    if (keycodes[i] == 0) {
+      return TrieInsertResult::kUnmapped;
+    }
+  }
+
+  int node = 0;
+  for (size_t i = 0; i < binding.steps.size(); i++) {
+    if ((*trie)[node].binding_id >= 0) {
+      return TrieInsertResult::kConflict;
+    }
+    unsigned int modifiers = binding.steps[i].modifiers;
+    int child = trie_find_child(*trie, node, keycodes[i], modifiers);
+    if (child < 0) {
+      child = static_cast<int>(trie->size());
+      trie->push_back({keycodes[i], modifiers, -1, (*trie)[node].first_child,
+                       -1, HotkeyAction::kNotify});
+      (*trie)[node].first_child = child;
+    }
+    node = child;
+  }
+  if ((*trie)[node].binding_id >= 0 || (*trie)[node].first_child >= 0) {
+    return TrieInsertResult::kConflict;
+  }
+  (*trie)[node].binding_id = binding.id;
+  (*trie)[node].action = binding.action;
+  return TrieInsertResult::kInserted;
+}
+
+// Abandons any partially typed chord and releases the keyboard.
+static void hotkey_manager_reset_chord(HotkeyManager* self) {
+  self->state = 0;
+  self->state_modifiers = 0;
+  if (self->keyboard_grabbed) {
+    XUngrabKeyboard(self->xdisplay, CurrentTime);
+    self->keyboard_grabbed = FALSE;
+  }
+  if (self->chord_timeout_id != 0) {
+    g_source_remove(self->chord_timeout_id);
+    self->chord_timeout_id = 0;
+  }
+}
+
+// Rebuilds the trie from the bindings and grabs the first key of every
+// chord on the root window. Bindings that cannot be inserted, typically
+// because the keyboard layout changed and lost one of their keys, are
+// skipped with a warning so the others keep working. Returns FALSE if the X
+// server refused a grab (typically because another client owns it).
+static gboolean hotkey_manager_rebuild(HotkeyManager* self) {
+  hotkey_manager_reset_chord(self);
+  XUngrabKey(self->xdisplay, AnyKey, AnyModifier, self->root);
+
+  std::vector<TrieNode>* trie = self->trie;
+  trie->clear();
+  trie->push_back({0, 0, -1, -1, -1, HotkeyAction::kNotify});
+  for (Binding& binding : *self->bindings) {
+    TrieInsertResult result = trie_insert(self->xdisplay, trie, binding);
+    bool active = result == TrieInsertResult::kInserted;
+    if (binding.active && !active) {
+      g_warning("Hotkey %" G_GINT64_FORMAT " is inactive: %s",
+                static_cast<gint64>(binding.id),
+                result == TrieInsertResult::kUnmapped
+                    ? "a key of its chord is not in the keyboard layout"
+                    : "its chord overlaps another hotkey");
+    }
+    binding.active = active;
+  }
+
+  gdk_x11_display_error_trap_push(self->display);
+  for (int child = (*trie)[0].first_child; child >= 0;
+       child = (*trie)[child].next_sibling) {
+    for (unsigned int ignored : kIgnoredModifiers) {
+      XGrabKey(self->xdisplay, (*trie)[child].keycode,
+               (*trie)[child].modifiers | ignored, self->root, False,
+               GrabModeAsync, GrabModeAsync);
+    }
+  }
+  return gdk_x11_display_error_trap_pop(self->display) == 0;
+}
+
+static gboolean chord_timeout_cb(gpointer user_data) {
+  HotkeyManager* self = HOTKEY_MANAGER(user_data);
+  self->chord_timeout_id = 0;
+  hotkey_manager_reset_chord(self);
+  return G_SOURCE_REMOVE;
+}
+
+static void hotkey_manager_run_action(HotkeyManager* self, HotkeyAction action,
+                                      Time time) {
+  if (self->window == nullptr) {
+    return;
+  }
+  switch (action) {
+    case HotkeyAction::kNotify:
+      break;
+    case HotkeyAction::kMinimize:
+      gtk_window_iconify(self->window);
+      break;
+    case HotkeyAction::kToggleMaximize:
+      if (gtk_window_is_maximized(self->window)) {
+        gtk_window_unmaximize(self->window);
+      } else {
+        gtk_window_maximize(self->window);
+      }
+      break;
+    case HotkeyAction::kClose:
+      gtk_window_close(self->window);
+      break;
+    case HotkeyAction::kPresent:
+      gtk_window_present_with_time(self->window, time);
+      break;
+  }
+}
+
+static void hotkey_manager_notify(HotkeyManager* self, int64_t binding_id,
+                                  Time time) {
+  g_signal_emit(self, signals[SIGNAL_ACTIVATED], 0,
+                static_cast<gint64>(binding_id), static_cast<guint>(time));
+  if (self->channel == nullptr) {
+    return;
+  }
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "id", fl_value_new_int(binding_id));
+  fl_value_set_string_take(args, "time", fl_value_new_int(time));
+  fl_method_channel_invoke_method(self->channel, "onHotkey", args, nullptr,
+                                  nullptr, nullptr);
+}
+
+// Sees every X event before GDK does. Key presses reported on the root
+// window come from our grabs and are matched against the chord trie.
+static GdkFilterReturn hotkey_manager_filter(GdkXEvent* gdk_xevent,
+                                             GdkEvent* event,
+                                             gpointer user_data) {
+  HotkeyManager* self = HOTKEY_MANAGER(user_data);
+  XEvent* xevent = static_cast<XEvent*>(gdk_xevent);
+
+  if (xevent->type == MappingNotify) {
+    XRefreshKeyboardMapping(&xevent->xmapping);
+    if (xevent->xmapping.request != MappingPointer &&
+        !hotkey_manager_rebuild(self)) {
+      g_warning("Failed to re-grab hotkeys after a keyboard mapping change");
+    }
+    return GDK_FILTER_CONTINUE;
+  }
+
+  if (xevent->type != KeyPress || xevent->xkey.window != self->root) {
+    return GDK_FILTER_CONTINUE;
+  }
+
+  // Modifier presses in the middle of a chord (e.g. releasing and pressing
+  // Super again) neither advance nor break it.
+  KeySym keysym = XLookupKeysym(&xevent->xkey, 0);
+  if (IsModifierKey(keysym)) {
+    return GDK_FILTER_REMOVE;
+  }
+
+  const std::vector<TrieNode>& trie = *self->trie;
+  KeyCode keycode = xevent->xkey.keycode;
+  unsigned int modifiers = xevent->xkey.state & kMatchedModifiers;
+  int node = trie_find_child(trie, self->state, keycode, modifiers);
+  if (node < 0 && self->state != 0) {
+    // Modifiers still held from the previous step, e.g. Super through
+    // "<Super>w 1", do not count against the next one.
+    node = trie_find_child(trie, self->state, keycode,
+                           modifiers & ~self->state_modifiers);
+  }
+  if (node < 0 && self->state != 0) {
+    // A wrong key cancels the chord but may itself start a new one.
+    hotkey_manager_reset_chord(self);
+    node = trie_find_child(trie, 0, keycode, modifiers);
+  }
+  if (node < 0) {
+    return GDK_FILTER_REMOVE;
+  }
+
+  if (trie[node].binding_id >= 0) {
+    hotkey_manager_reset_chord(self);
+    hotkey_manager_run_action(self, trie[node].action, xevent->xkey.time);
+    hotkey_manager_notify(self, trie[node].binding_id, xevent->xkey.time);
+    return GDK_FILTER_REMOVE;
+  }
+
+  // Chord prefix: hold the whole keyboard until the chord completes so the
+  // following keys, which are not grabbed themselves, reach us.
+  self->state = node;
+  self->state_modifiers = trie[node].modifiers;
+  if (!self->keyboard_grabbed) {
+    self->keyboard_grabbed =
+        XGrabKeyboard(self->xdisplay, self->root, False, GrabModeAsync,
+                      GrabModeAsync, xevent->xkey.time) == GrabSuccess;
+  }
+  if (self->chord_timeout_id != 0) {
+    g_source_remove(self->chord_timeout_id);
+  }
+  self->chord_timeout_id =
+      g_timeout_add(kChordTimeoutMs, chord_timeout_cb, self);
+  return GDK_FILTER_REMOVE;
+}
+
+gboolean hotkey_manager_bind(HotkeyManager* self, int64_t id,
+                             const gchar* chord, const gchar* action,
+                             GError** error) {
+  g_return_val_if_fail(HOTKEY_IS_MANAGER(self), FALSE);
+  g_return_val_if_fail(chord != nullptr, FALSE);
+
+  if (self->xdisplay == nullptr) {
+    g_set_error(error, HOTKEY_MANAGER_ERROR, HOTKEY_MANAGER_ERROR_UNSUPPORTED,
+                "Global hotkeys require an X11 display");
+    return FALSE;
+  }
+  Binding binding;
+  binding.id = id;
+  if (binding.id < 0 || !parse_chord(chord, &binding.steps)) {
+    g_set_error(error, HOTKEY_MANAGER_ERROR, HOTKEY_MANAGER_ERROR_INVALID,
+                "Invalid hotkey id or chord");
+    return FALSE;
+  }
+  if (!parse_action(action, &binding.action)) {
+    g_set_error(error, HOTKEY_MANAGER_ERROR, HOTKEY_MANAGER_ERROR_INVALID,
+                "Unknown hotkey action");
+    return FALSE;
+  }
+  for (const Binding& existing : *self->bindings) {
+    if (existing.id == binding.id) {
+      g_set_error(error, HOTKEY_MANAGER_ERROR, HOTKEY_MANAGER_ERROR_CONFLICT,
+                  "Hotkey id is already bound");
+      return FALSE;
+    }
+  }
+  // Check the chord against the active bindings before grabbing anything.
+  std::vector<TrieNode> trie = *self->trie;
+  switch (trie_insert(self->xdisplay, &trie, binding)) {
+    case TrieInsertResult::kInserted:
+      break;
+    case TrieInsertResult::kUnmapped:
+      g_set_error(error, HOTKEY_MANAGER_ERROR, HOTKEY_MANAGER_ERROR_INVALID,
+                  "Chord uses a key missing from the keyboard layout");
+      return FALSE;
+    case TrieInsertResult::kConflict:
+      g_set_error(error, HOTKEY_MANAGER_ERROR, HOTKEY_MANAGER_ERROR_CONFLICT,
+                  "Chord overlaps an existing hotkey");
+      return FALSE;
+  }
+
+  binding.active = true;
+  self->bindings->push_back(binding);
+  if (!hotkey_manager_rebuild(self)) {
+    self->bindings->pop_back();
+    hotkey_manager_rebuild(self);
+    g_set_error(error, HOTKEY_MANAGER_ERROR, HOTKEY_MANAGER_ERROR_CONFLICT,
+                "Chord is grabbed by another client");
+    return FALSE;
+  }
+  return TRUE;
+}
+
+void hotkey_manager_unbind(HotkeyManager* self, int64_t id) {
+  g_return_if_fail(HOTKEY_IS_MANAGER(self));
+
+  std::vector<Binding>* bindings = self->bindings;
+  for (auto it = bindings->begin(); it != bindings->end(); ++it) {
+    if (it->id == id) {
+      bindings->erase(it);
+      if (self->xdisplay != nullptr) {
+        hotkey_manager_rebuild(self);
+      }
+      break;
+    }
+  }
+}
+
+static FlMethodResponse* bind_method(HotkeyManager* self, FlValue* args) {
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad_args", "Expected a map argument", nullptr));
+  }
+  FlValue* id = fl_value_lookup_string(args, "id");
+  FlValue* chord = fl_value_lookup_string(args, "chord");
+  FlValue* action = fl_value_lookup_string(args, "action");
+  if (id == nullptr || fl_value_get_type(id) != FL_VALUE_TYPE_INT ||
+      chord == nullptr || fl_value_get_type(chord) != FL_VALUE_TYPE_STRING ||
+      (action != nullptr &&
+       fl_value_get_type(action) != FL_VALUE_TYPE_STRING)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad_args", "Expected int id, string chord and optional string action",
+        nullptr));
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!hotkey_manager_bind(
+          self, fl_value_get_int(id), fl_value_get_string(chord),
+          action != nullptr ? fl_value_get_string(action) : nullptr, &error)) {
+    const gchar* code = "conflict";
+    if (error->code == HOTKEY_MANAGER_ERROR_UNSUPPORTED) {
+      code = "unsupported";
+    } else if (error->code == HOTKEY_MANAGER_ERROR_INVALID) {
+      code = "bad_args";
+    }
+    return FL_METHOD_RESPONSE(
+        fl_method_error_response_new(code, error->message, nullptr));
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+static FlMethodResponse* unbind_method(HotkeyManager* self, FlValue* args) {
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_INT) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad_args", "Expected an int hotkey id", nullptr));
+  }
+  hotkey_manager_unbind(self, fl_value_get_int(args));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+static void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
+                           gpointer user_data) {
+  HotkeyManager* self = HOTKEY_MANAGER(user_data);
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "bind") == 0) {
+    response = bind_method(self, args);
+  } else if (strcmp(method, "unbind") == 0) {
+    response = unbind_method(self, args);
+  } else {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error)) {
+    g_warning("Failed to send hotkey response: %s", error->message);
+  }
+}
+
+// Implements GObject::dispose.
+static void hotkey_manager_dispose(GObject* object) {
+  HotkeyManager* self = HOTKEY_MANAGER(object);
+
+  if (self->xdisplay != nullptr) {
+    gdk_window_remove_filter(nullptr, hotkey_manager_filter, self);
+    hotkey_manager_reset_chord(self);
+    XUngrabKey(self->xdisplay, AnyKey, AnyModifier, self->root);
+    self->xdisplay = nullptr;
+  }
+  if (self->window != nullptr) {
+    g_object_remove_weak_pointer(G_OBJECT(self->window),
+                                 reinterpret_cast<gpointer*>(&self->window));
+    self->window = nullptr;
+  }
+  g_clear_object(&self->channel);
+  delete self->bindings;
+  self->bindings = nullptr;
+  delete self->trie;
+  self->trie = nullptr;
+
+  G_OBJECT_CLASS(hotkey_manager_parent_class)->dispose(object);
+}
+
+static void hotkey_manager_class_init(HotkeyManagerClass* klass) {
+  G_OBJECT_CLASS(klass)->dispose = hotkey_manager_dispose;
+
+  signals[SIGNAL_ACTIVATED] = g_signal_new(
+      "activated", hotkey_manager_get_type(), G_SIGNAL_RUN_LAST, 0, nullptr,
+      nullptr, nullptr, G_TYPE_NONE, 2, G_TYPE_INT64, G_TYPE_UINT);
+}
+
+static void hotkey_manager_init(HotkeyManager* self) {
+  self->bindings = new std::vector<Binding>();
+  self->trie = new std::vector<TrieNode>();
+}
+
+HotkeyManager* hotkey_manager_new(GtkWindow* window,
+                                  FlBinaryMessenger* messenger) {
+  HotkeyManager* self =
+      HOTKEY_MANAGER(g_object_new(hotkey_manager_get_type(), nullptr));
+
+  self->window = window;
+  g_object_add_weak_pointer(G_OBJECT(window),
+                            reinterpret_cast<gpointer*>(&self->window));
+
+  GdkDisplay* display = gtk_widget_get_display(GTK_WIDGET(window));
+  if (GDK_IS_X11_DISPLAY(display)) {
+    self->display = display;
+    self->xdisplay = gdk_x11_display_get_xdisplay(display);
+    self->root = DefaultRootWindow(self->xdisplay);
+    hotkey_manager_rebuild(self);
+    gdk_window_add_filter(nullptr, hotkey_manager_filter, self);
+  }
+
+  if (messenger == nullptr) {
+    return self;
+  }
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  self->channel = fl_method_channel_new(messenger, kChannelName,
+                                        FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(self->channel, method_call_cb,
+                                            self, nullptr);
+
+  return self;
+}
@@ -0,0 +1,79 @@
+#ifndef FLUTTER_HOTKEY_MANAGER_H_
+#define FLUTTER_HOTKEY_MANAGER_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <gtk/gtk.h>
+
+#include <stdint.h>
+
+G_DECLARE_FINAL_TYPE(HotkeyManager, hotkey_manager, HOTKEY, MANAGER, GObject)
+
+#define HOTKEY_MANAGER_ERROR hotkey_manager_error_quark()
+
+typedef enum {
+  HOTKEY_MANAGER_ERROR_UNSUPPORTED,
+  HOTKEY_MANAGER_ERROR_INVALID,
+  HOTKEY_MANAGER_ERROR_CONFLICT,
+} HotkeyManagerError;
+
+GQuark hotkey_manager_error_quark();
+
+/**
+ * hotkey_manager_new:
+ * @window: the #GtkWindow that bound window actions operate on.
+ * @messenger: (allow-none): the #FlBinaryMessenger used for the "hotkeys"
+ *   channel, or %NULL to only drive the manager from native code.
+ *
+ * Creates a native global hotkey engine. Chords such as "<Super>w 1" are
+ * grabbed on the X11 root window and matched natively, so bound window
+ * actions run even while the Dart isolate is busy. Dart only receives an
+ * "onHotkey" notification after the action has been performed, at the same
+ * time as the #HotkeyManager::activated signal (gint64 id, guint X time).
+ *
+ * Modifiers of one chord step may stay held while typing the next, so
+ * "<Super>w 1" matches whether or not Super is released before "1".
+ *
+ * When a keyboard layout change leaves a key of a chord without a keycode,
+ * that binding is inactive until a layout maps it again; the others stay
+ * grabbed.
+ *
+ * Global grabs are only available on X11; on other backends every bind
+ * request fails with an "unsupported" error.
+ *
+ * Returns: a new #HotkeyManager.
+ */
+HotkeyManager* hotkey_manager_new(GtkWindow* window,
+                                  FlBinaryMessenger* messenger);
+
+/**
+ * hotkey_manager_bind:
+ * @manager: a #HotkeyManager.
+ * @id: a non-negative id reported when the chord is typed.
+ * @chord: a space separated chord, e.g. "<Super>w 1".
+ * @action: (allow-none): "notify", "minimize", "toggleMaximize", "close" or
+ *   "present"; %NULL means "notify".
+ * @error: (allow-none): #GError location to store the error occurring, or
+ *   %NULL to ignore.
+ *
+ * Grabs @chord and binds it to @action. This is what the "bind" method of
+ * the "hotkeys" channel calls. Fails with %HOTKEY_MANAGER_ERROR_INVALID if a
+ * key of @chord is not in the current keyboard layout, and with
+ * %HOTKEY_MANAGER_ERROR_CONFLICT if the chord overlaps another one or is
+ * grabbed by another client.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean hotkey_manager_bind(HotkeyManager* manager, int64_t id,
+                             const gchar* chord, const gchar* action,
+                             GError** error);
+
+/**
+ * hotkey_manager_unbind:
+ * @manager: a #HotkeyManager.
+ * @id: id of a bound chord. Unknown ids are ignored.
+ *
+ * Releases the chord bound with @id.
+ */
+void hotkey_manager_unbind(HotkeyManager* manager, int64_t id);
+
+#endif  // FLUTTER_HOTKEY_MANAGER_H_
@@ -0,0 +1,86 @@
+#include "latency_histogram.h"
+
+namespace {
+
+constexpr int kHalfSubBuckets = LATENCY_HISTOGRAM_SUB_BUCKETS / 2;
+
+// log2(LATENCY_HISTOGRAM_SUB_BUCKETS) - 1: values whose highest set bit is
+// above this are shifted down into the upper half of the sub-buckets.
+constexpr int kSubBucketShift = 6;
+
+int bucket_index(int64_t value) {
+  uint64_t bits =
+      static_cast<uint64_t>(value) | (LATENCY_HISTOGRAM_SUB_BUCKETS - 1);
+  int shift = 63 - __builtin_clzll(bits) - kSubBucketShift;
+  return shift * kHalfSubBuckets + static_cast<int>(value >> shift);
+}
+
+int64_t bucket_upper_bound(int index) {
+  int shift = index < LATENCY_HISTOGRAM_SUB_BUCKETS
+                  ? 0
+                  : index / kHalfSubBuckets - 1;
+  int64_t sub_bucket = index - shift * kHalfSubBuckets;
+  return ((sub_bucket + 1) << shift) - 1;
+}
+
+}  // namespace
+
+void latency_histogram_record(LatencyHistogram* histogram, int64_t value_us) {
+  if (value_us < 0) {
+    value_us = 0;
+  } else if (value_us > LATENCY_HISTOGRAM_MAX_US) {
+    value_us = LATENCY_HISTOGRAM_MAX_US;
+  }
+  histogram->counts[bucket_index(value_us)].fetch_add(
+      1, std::memory_order_relaxed);
+
+  int64_t max = histogram->max_us.load(std::memory_order_relaxed);
+  while (value_us > max && !histogram->max_us.compare_exchange_weak(
+                               max, value_us, std::memory_order_relaxed)) {
+  }
+  // Published last so readers that see the count also see the bucket.
+  histogram->total_count.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t latency_histogram_total_count(const LatencyHistogram* histogram) {
+  return histogram->total_count.load(std::memory_order_acquire);
+}
+
+int64_t latency_histogram_max(const LatencyHistogram* histogram) {
+  return histogram->max_us.load(std::memory_order_relaxed);
+}
+
+int64_t latency_histogram_value_at_percentile(
+    const LatencyHistogram* histogram, double percentile) {
+  uint64_t total = latency_histogram_total_count(histogram);
+  if (total == 0) {
+    return 0;
+  }
+  if (percentile < 0.0) {
+    percentile = 0.0;
+  } else if (percentile > 100.0) {
+    percentile = 100.0;
+  }
+  uint64_t target = static_cast<uint64_t>(percentile / 100.0 * total + 0.5);
+  if (target == 0) {
+    target = 1;
+  }
+
+  uint64_t seen = 0;
+  for (int index = 0; index < LATENCY_HISTOGRAM_BUCKETS; index++) {
+    seen += histogram->counts[index].load(std::memory_order_relaxed);
+    if (seen >= target) {
+      return bucket_upper_bound(index);
+    }
+  }
+  // Samples still being recorded may not have reached their bucket yet.
+  return latency_histogram_max(histogram);
+}
+
+void latency_histogram_reset(LatencyHistogram* histogram) {
+  histogram->total_count.store(0, std::memory_order_relaxed);
+  for (std::atomic<uint64_t>& count : histogram->counts) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  histogram->max_us.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,47 @@
+#ifndef FLUTTER_LATENCY_HISTOGRAM_H_
+#define FLUTTER_LATENCY_HISTOGRAM_H_
+
+#include <stdint.h>
+
+#include <atomic>
+
+// Values below this are counted exactly; above it each power of two is split
+// into LATENCY_HISTOGRAM_SUB_BUCKETS / 2 linear buckets, keeping the
+// relative error under 1.6%.
+#define LATENCY_HISTOGRAM_SUB_BUCKETS 128
+
+// Largest recordable latency (~67 s); longer ones are clamped.
+#define LATENCY_HISTOGRAM_MAX_US ((INT64_C(1) << 26) - 1)
+
+#define LATENCY_HISTOGRAM_BUCKETS \
+  ((26 - 6) * (LATENCY_HISTOGRAM_SUB_BUCKETS / 2) + \
+   LATENCY_HISTOGRAM_SUB_BUCKETS / 2)
+
+// A high dynamic range histogram of latencies in microseconds. Recording and
+// reading are lock-free, so values can be added on the GTK main thread
+// while Dart queries percentiles from its own thread. Zero-initialized
+// storage is an empty histogram.
+typedef struct {
+  std::atomic<uint64_t> counts[LATENCY_HISTOGRAM_BUCKETS];
+  std::atomic<uint64_t> total_count;
+  std::atomic<int64_t> max_us;
+} LatencyHistogram;
+
+// Adds one latency sample of |value_us| microseconds.
+void latency_histogram_record(LatencyHistogram* histogram, int64_t value_us);
+
+// Returns the number of recorded samples.
+uint64_t latency_histogram_total_count(const LatencyHistogram* histogram);
+
+// Returns the largest recorded sample in microseconds.
+int64_t latency_histogram_max(const LatencyHistogram* histogram);
+
+// Returns the latency at |percentile| (0-100) in microseconds, as the upper
+// bound of the bucket that holds it, or 0 if the histogram is empty.
+int64_t latency_histogram_value_at_percentile(
+    const LatencyHistogram* histogram, double percentile);
+
+// Discards all samples. Samples recorded concurrently may be kept or lost.
+void latency_histogram_reset(LatencyHistogram* histogram);
+
+#endif  // FLUTTER_LATENCY_HISTOGRAM_H_
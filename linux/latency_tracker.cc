@@ -0,0 +1,360 @@
+#include "latency_tracker.h"
+
+#include <atomic>
+#include <cstdio>
+
+#include "latency_histogram.h"
+
+namespace {
+
+const char* const kTypeNames[LATENCY_EVENT_TYPE_COUNT] = {
+    "drag_motion",
+    "click",
+    "resize",
+};
+
+const double kDumpPercentiles[] = {50.0, 90.0, 99.0, 99.9};
+
+// Event timestamps further in the past than this are assumed to come from a
+// clock other than CLOCK_MONOTONIC; receipt time is used instead.
+constexpr guint32 kMaxEventAgeMs = 10000;
+
+// Samples whose response has not been painted within this time are dropped
+// rather than left pending forever.
+constexpr gint64 kMaxPendingUs = 5 * G_USEC_PER_SEC;
+
+// Events of one type in flight at once, e.g. a frame's worth of 1000 Hz
+// pointer motion plus the frames it takes for presentation times to arrive.
+// Further events are not sampled until the queue drains.
+constexpr int kMaxPendingSamples = 128;
+
+// Frame counter of a sample that expired before any frame covered it.
+constexpr gint64 kExpiredFrame = -1;
+
+// An event waiting for the frame that covers it to be presented.
+struct PendingSample {
+  // Monotonic time of the event.
+  gint64 start_us;
+  // GDK timestamp of the event, GDK_CURRENT_TIME for resizes.
+  guint32 event_time_ms;
+  // Position of the event among those of its type, starting at 1.
+  int64_t sequence;
+  // Counter of the first frame painted after the event was handled, 0 until
+  // painted, or kExpiredFrame.
+  gint64 frame_counter;
+  // Monotonic time at which that frame finished painting.
+  gint64 paint_us;
+};
+
+// Pending events of one type, oldest first. Samples assigned to a frame
+// always precede unassigned ones, as frames are painted in order.
+struct PendingQueue {
+  PendingSample samples[kMaxPendingSamples];
+  int head;
+  int count;
+};
+
+}  // namespace
+
+// Histograms are global so that FFI queries need no handle and stay valid
+// after the tracker is gone.
+static LatencyHistogram histograms[LATENCY_EVENT_TYPE_COUNT];
+
+// Sequence number of the last event of each type received, written on the
+// GTK main thread and read by latency_tracker_mark_handled().
+static std::atomic<int64_t> received_sequence[LATENCY_EVENT_TYPE_COUNT];
+
+// Written by Dart through FFI, read on the GTK main thread. Events are
+// handled in order, so Dart reports the last event it handled, either by
+// GDK timestamp or as everything received so far; 0 when not reported yet.
+static std::atomic<bool> dart_marks_used[LATENCY_EVENT_TYPE_COUNT];
+static std::atomic<int64_t> dart_handled_time_ms[LATENCY_EVENT_TYPE_COUNT];
+static std::atomic<int64_t> dart_handled_sequence[LATENCY_EVENT_TYPE_COUNT];
+
+struct _LatencyTracker {
+  GObject parent_instance;
+
+  // Window being measured (weak reference).
+  GtkWindow* window;
+
+  GdkFrameClock* frame_clock;
+
+  guint button_press_signal_id;
+  gulong button_press_hook_id;
+  guint motion_signal_id;
+  gulong motion_hook_id;
+
+  PendingQueue pending[LATENCY_EVENT_TYPE_COUNT];
+
+  // Size from the last configure event, -1 before the first one.
+  gint last_width;
+  gint last_height;
+};
+
+G_DEFINE_TYPE(LatencyTracker, latency_tracker, G_TYPE_OBJECT)
+
+// Converts a GDK event timestamp (milliseconds) to monotonic microseconds.
+// X11 and Wayland servers on Linux both stamp events from CLOCK_MONOTONIC.
+static gint64 event_start_time(guint32 event_time_ms) {
+  gint64 now_us = g_get_monotonic_time();
+  guint32 age_ms = static_cast<guint32>(now_us / 1000) - event_time_ms;
+  if (event_time_ms == GDK_CURRENT_TIME || age_ms > kMaxEventAgeMs) {
+    return now_us;
+  }
+  return now_us - static_cast<gint64>(age_ms) * 1000;
+}
+
+static void latency_tracker_begin(LatencyTracker* self, LatencyEventType type,
+                                  guint32 event_time_ms) {
+  PendingQueue* queue = &self->pending[type];
+  if (queue->count == kMaxPendingSamples) {
+    return;
+  }
+  int64_t sequence =
+      received_sequence[type].load(std::memory_order_relaxed) + 1;
+  received_sequence[type].store(sequence, std::memory_order_relaxed);
+  queue->samples[(queue->head + queue->count) % kMaxPendingSamples] = {
+      event_start_time(event_time_ms), event_time_ms, sequence, 0, 0};
+  queue->count++;
+}
+
+// Whether Dart has handled |sample| of |type|. Until Dart reports handling
+// for a type at all, every event counts as handled.
+static gboolean sample_handled(LatencyEventType type,
+                               const PendingSample* sample) {
+  if (!dart_marks_used[type].load(std::memory_order_relaxed)) {
+    return TRUE;
+  }
+  if (sample->sequence <=
+      dart_handled_sequence[type].load(std::memory_order_relaxed)) {
+    return TRUE;
+  }
+  // GDK timestamps wrap around every ~49 days.
+  int64_t handled_ms =
+      dart_handled_time_ms[type].load(std::memory_order_relaxed);
+  return handled_ms != 0 && sample->event_time_ms != GDK_CURRENT_TIME &&
+         static_cast<gint32>(sample->event_time_ms -
+                             static_cast<guint32>(handled_ms)) <= 0;
+}
+
+static gboolean input_hook(GSignalInvocationHint* hint, guint n_param_values,
+                           const GValue* param_values, gpointer user_data) {
+  LatencyTracker* self = LATENCY_TRACKER(user_data);
+  GtkWidget* widget = GTK_WIDGET(g_value_get_object(&param_values[0]));
+  GdkEvent* event = static_cast<GdkEvent*>(g_value_get_boxed(&param_values[1]));
+  if (self->window == nullptr || event == nullptr ||
+      gtk_widget_get_toplevel(widget) != GTK_WIDGET(self->window)) {
+    return TRUE;
+  }
+
+  if (event->type == GDK_BUTTON_PRESS) {
+    latency_tracker_begin(self, LATENCY_EVENT_CLICK, event->button.time);
+  } else if (event->type == GDK_MOTION_NOTIFY &&
+             (event->motion.state &
+              (GDK_BUTTON1_MASK | GDK_BUTTON2_MASK | GDK_BUTTON3_MASK))) {
+    latency_tracker_begin(self, LATENCY_EVENT_DRAG_MOTION, event->motion.time);
+  }
+  return TRUE;
+}
+
+static gboolean configure_cb(GtkWidget* widget, GdkEventConfigure* event,
+                             gpointer user_data) {
+  LatencyTracker* self = LATENCY_TRACKER(user_data);
+  // Moves and restacks are configures too; only a size change is a resize.
+  gboolean resized = self->last_width >= 0 &&
+                     (event->width != self->last_width ||
+                      event->height != self->last_height);
+  self->last_width = event->width;
+  self->last_height = event->height;
+  if (resized) {
+    latency_tracker_begin(self, LATENCY_EVENT_RESIZE, GDK_CURRENT_TIME);
+  }
+  return FALSE;
+}
+
+// Assigns pending events to the frame just painted and records those whose
+// frame has been presented.
+static void after_paint_cb(GdkFrameClock* frame_clock, gpointer user_data) {
+  LatencyTracker* self = LATENCY_TRACKER(user_data);
+  gint64 now_us = g_get_monotonic_time();
+  gint64 frame_counter = gdk_frame_clock_get_frame_counter(frame_clock);
+  gboolean waiting = FALSE;
+
+  for (int type = 0; type < LATENCY_EVENT_TYPE_COUNT; type++) {
+    PendingQueue* queue = &self->pending[type];
+    for (int i = 0; i < queue->count; i++) {
+      PendingSample* sample =
+          &queue->samples[(queue->head + i) % kMaxPendingSamples];
+      if (sample->frame_counter != 0) {
+        continue;
+      }
+      if (now_us - sample->start_us > kMaxPendingUs) {
+        sample->frame_counter = kExpiredFrame;
+      } else if (sample_handled(static_cast<LatencyEventType>(type),
+                                sample)) {
+        sample->frame_counter = frame_counter;
+        sample->paint_us = now_us;
+      }
+    }
+
+    while (queue->count > 0) {
+      PendingSample* sample = &queue->samples[queue->head];
+      if (sample->frame_counter == 0) {
+        break;
+      }
+      if (sample->frame_counter != kExpiredFrame) {
+        // Presentation times arrive a frame or two later. Frames that
+        // dropped out of the clock's history fall back to the paint time.
+        GdkFrameTimings* timings =
+            gdk_frame_clock_get_timings(frame_clock, sample->frame_counter);
+        if (timings != nullptr && !gdk_frame_timings_get_complete(timings)) {
+          waiting = TRUE;
+          break;
+        }
+        gint64 presented_us =
+            timings != nullptr
+                ? gdk_frame_timings_get_presentation_time(timings)
+                : 0;
+        if (presented_us == 0) {
+          presented_us = sample->paint_us;
+        }
+        latency_histogram_record(&histograms[type],
+                                 presented_us - sample->start_us);
+      }
+      queue->head = (queue->head + 1) % kMaxPendingSamples;
+      queue->count--;
+    }
+  }
+
+  if (waiting) {
+    gdk_frame_clock_request_phase(frame_clock,
+                                  GDK_FRAME_CLOCK_PHASE_AFTER_PAINT);
+  }
+}
+
+static void latency_tracker_dump(const gchar* path) {
+  FILE* file = g_strcmp0(path, "-") == 0 ? stderr : fopen(path, "w");
+  if (file == nullptr) {
+    g_warning("Failed to open latency dump %s", path);
+    return;
+  }
+  for (int type = 0; type < LATENCY_EVENT_TYPE_COUNT; type++) {
+    const LatencyHistogram* histogram = &histograms[type];
+    fprintf(file, "%s count=%" G_GUINT64_FORMAT, kTypeNames[type],
+            latency_histogram_total_count(histogram));
+    for (double percentile : kDumpPercentiles) {
+      fprintf(file, " p%g=%" G_GINT64_FORMAT "us", percentile,
+              latency_histogram_value_at_percentile(histogram, percentile));
+    }
+    fprintf(file, " max=%" G_GINT64_FORMAT "us\n",
+            latency_histogram_max(histogram));
+  }
+  if (file != stderr) {
+    fclose(file);
+  }
+}
+
+// Implements GObject::dispose.
+static void latency_tracker_dispose(GObject* object) {
+  LatencyTracker* self = LATENCY_TRACKER(object);
+
+  if (self->button_press_hook_id != 0) {
+    g_signal_remove_emission_hook(self->button_press_signal_id,
+                                  self->button_press_hook_id);
+    self->button_press_hook_id = 0;
+    g_signal_remove_emission_hook(self->motion_signal_id,
+                                  self->motion_hook_id);
+    self->motion_hook_id = 0;
+
+    const gchar* dump_path = g_getenv("LATENCY_HISTOGRAM_DUMP");
+    if (dump_path != nullptr) {
+      latency_tracker_dump(dump_path);
+    }
+  }
+  if (self->frame_clock != nullptr) {
+    g_signal_handlers_disconnect_by_data(self->frame_clock, self);
+    g_clear_object(&self->frame_clock);
+  }
+  if (self->window != nullptr) {
+    g_signal_handlers_disconnect_by_data(self->window, self);
+    g_object_remove_weak_pointer(G_OBJECT(self->window),
+                                 reinterpret_cast<gpointer*>(&self->window));
+    self->window = nullptr;
+  }
+
+  G_OBJECT_CLASS(latency_tracker_parent_class)->dispose(object);
+}
+
+static void latency_tracker_class_init(LatencyTrackerClass* klass) {
+  G_OBJECT_CLASS(klass)->dispose = latency_tracker_dispose;
+}
+
+static void latency_tracker_init(LatencyTracker* self) {
+  self->last_width = -1;
+  self->last_height = -1;
+}
+
+LatencyTracker* latency_tracker_new(GtkWindow* window) {
+  LatencyTracker* self =
+      LATENCY_TRACKER(g_object_new(latency_tracker_get_type(), nullptr));
+
+  self->window = window;
+  g_object_add_weak_pointer(G_OBJECT(window),
+                            reinterpret_cast<gpointer*>(&self->window));
+
+  // Input is consumed by the Flutter view before it reaches the window, so
+  // watch it with emission hooks.
+  self->button_press_signal_id =
+      g_signal_lookup("button-press-event", GTK_TYPE_WIDGET);
+  self->button_press_hook_id = g_signal_add_emission_hook(
+      self->button_press_signal_id, 0, input_hook, self, nullptr);
+  self->motion_signal_id =
+      g_signal_lookup("motion-notify-event", GTK_TYPE_WIDGET);
+  self->motion_hook_id = g_signal_add_emission_hook(
+      self->motion_signal_id, 0, input_hook, self, nullptr);
+  g_signal_connect(window, "configure-event", G_CALLBACK(configure_cb), self);
+
+  GdkFrameClock* frame_clock = gtk_widget_get_frame_clock(GTK_WIDGET(window));
+  if (frame_clock != nullptr) {
+    self->frame_clock = GDK_FRAME_CLOCK(g_object_ref(frame_clock));
+    g_signal_connect(frame_clock, "after-paint", G_CALLBACK(after_paint_cb),
+                     self);
+  }
+
+  return self;
+}
+
+void latency_tracker_mark_handled(int32_t type, int64_t event_time_ms) {
+  if (type < 0 || type >= LATENCY_EVENT_TYPE_COUNT) {
+    return;
+  }
+  if (event_time_ms > 0) {
+    dart_handled_time_ms[type].store(event_time_ms, std::memory_order_relaxed);
+  } else {
+    dart_handled_sequence[type].store(
+        received_sequence[type].load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+  }
+  dart_marks_used[type].store(true, std::memory_order_relaxed);
+}
+
+int64_t latency_tracker_percentile(int32_t type, double percentile) {
+  if (type < 0 || type >= LATENCY_EVENT_TYPE_COUNT) {
+    return 0;
+  }
+  return latency_histogram_value_at_percentile(&histograms[type], percentile);
+}
+
+uint64_t latency_tracker_count(int32_t type) {
+  if (type < 0 || type >= LATENCY_EVENT_TYPE_COUNT) {
+    return 0;
+  }
+  return latency_histogram_total_count(&histograms[type]);
+}
+
+void latency_tracker_reset(int32_t type) {
+  if (type < 0 || type >= LATENCY_EVENT_TYPE_COUNT) {
+    return;
+  }
+  latency_histogram_reset(&histograms[type]);
+}
@@ -0,0 +1,90 @@
+#ifndef FLUTTER_LATENCY_TRACKER_H_
+#define FLUTTER_LATENCY_TRACKER_H_
+
+#include <gmodule.h>
+#include <gtk/gtk.h>
+
+#include <stdint.h>
+
+// Kinds of input whose latency is tracked separately.
+typedef enum {
+  // Pointer motion with a button held, i.e. dragging.
+  LATENCY_EVENT_DRAG_MOTION,
+  LATENCY_EVENT_CLICK,
+  LATENCY_EVENT_RESIZE,
+  LATENCY_EVENT_TYPE_COUNT,
+} LatencyEventType;
+
+G_DECLARE_FINAL_TYPE(LatencyTracker, latency_tracker, LATENCY, TRACKER,
+                     GObject)
+
+/**
+ * latency_tracker_new:
+ * @window: the #GtkWindow whose input and frames are measured.
+ *
+ * Measures input-to-present latency: from the GDK event timestamp, through
+ * Dart handling, to the presentation of the first frame painted afterwards.
+ * Every event is recorded against the frame that covers it, so a burst of
+ * motion events within one frame yields one sample each. Up to 128 events
+ * per #LatencyEventType may await presentation at once; events beyond that
+ * are not sampled. Samples go into one lock-free histogram per
+ * #LatencyEventType.
+ *
+ * If the `LATENCY_HISTOGRAM_DUMP` environment variable is set, percentiles
+ * are written to that path ("-" for stderr) when the tracker is disposed.
+ *
+ * Returns: a new #LatencyTracker.
+ */
+LatencyTracker* latency_tracker_new(GtkWindow* window);
+
+G_BEGIN_DECLS
+
+/**
+ * latency_tracker_mark_handled:
+ * @type: a #LatencyEventType.
+ * @event_time_ms: GDK timestamp in milliseconds of the last event of @type
+ *   that Dart has handled, as in `PointerEvent.timeStamp`, or 0 to mark
+ *   every event of @type received so far, e.g. for resizes, which have no
+ *   timestamp.
+ *
+ * FFI entry point for Dart to report which events of @type it has handled;
+ * events are handled in order, so this covers every earlier event too.
+ * Once called for a type, each of its events is assigned to the first frame
+ * painted after it has been marked; until then, to the next painted frame.
+ */
+G_MODULE_EXPORT void latency_tracker_mark_handled(int32_t type,
+                                                  int64_t event_time_ms);
+
+/**
+ * latency_tracker_percentile:
+ * @type: a #LatencyEventType.
+ * @percentile: percentile to query, between 0 and 100.
+ *
+ * FFI entry point. Safe to call from any thread.
+ *
+ * Returns: the latency at @percentile in microseconds, or 0 if no samples.
+ */
+G_MODULE_EXPORT int64_t latency_tracker_percentile(int32_t type,
+                                                   double percentile);
+
+/**
+ * latency_tracker_count:
+ * @type: a #LatencyEventType.
+ *
+ * FFI entry point. Safe to call from any thread.
+ *
+ * Returns: the number of samples recorded for @type.
+ */
+G_MODULE_EXPORT uint64_t latency_tracker_count(int32_t type);
+
+/**
+ * latency_tracker_reset:
+ * @type: a #LatencyEventType.
+ *
+ * FFI entry point discarding the samples recorded for @type.
+ */
+G_MODULE_EXPORT void latency_tracker_reset(int32_t type);
+
+G_END_DECLS
+
+#endif  // FLUTTER_LATENCY_TRACKER_H_
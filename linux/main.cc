@@ -1,6 +1,13 @@
 #include "my_application.h"
+#include "startup_prefetch.h"
 
 int main(int argc, char** argv) {
+  // Warm the page cache for the Flutter bundle while GTK initializes.
+  startup_prefetch_start();
+
   g_autoptr(MyApplication) app = my_application_new();
-  return g_application_run(G_APPLICATION(app), argc, argv);
+  int status = g_application_run(G_APPLICATION(app), argc, argv);
+
+  startup_prefetch_finish();
+  return status;
 }
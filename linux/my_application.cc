@@ -5,15 +5,36 @@
 #include <gdk/gdkx.h>
 #endif
 
+#include "drag_drop.h"
 #include "flutter/generated_plugin_registrant.h"
+#include "hotkey_manager.h"
+#include "latency_tracker.h"
+#include "startup_prefetch.h"
+#include "window_mru.h"
+#include "window_ops.h"
 
 struct _MyApplication {
   GtkApplication parent_instance;
   char** dart_entrypoint_arguments;
+  DragDrop* drag_drop;
+  HotkeyManager* hotkey_manager;
+  LatencyTracker* latency_tracker;
+  WindowMru* window_mru;
+  WindowOps* window_ops;
 };
 
 G_DEFINE_TYPE(MyApplication, my_application, GTK_TYPE_APPLICATION)
 
+// Called once the first Flutter frame has been presented. Benchmark builds
+// (configured with -DSTARTUP_BENCHMARK=ON) quit right away, so that
+// test/startup_benchmark.sh can time startup as the process run time.
+static void first_frame_cb(FlView* view, gpointer user_data) {
+  startup_prefetch_first_frame();
+#ifdef STARTUP_BENCHMARK
+  g_application_quit(G_APPLICATION(user_data));
+#endif
+}
+
 // Implements GApplication::activate.
 static void my_application_activate(GApplication* application) {
   MyApplication* self = MY_APPLICATION(application);
@@ -26,7 +47,8 @@ static void my_application_activate(GApplication* application) {
   // If running on X and not using GNOME then just use a traditional title bar
   // in case the window manager does more exotic layout, e.g. tiling.
   // If running on Wayland assume the header bar will work (may need changing
-  // if future cases occur).
+  // if future cases occur). Native window operations pick their own backend
+  // for the display in use, see window_ops.h.
   gboolean use_header_bar = TRUE;
 #ifdef GDK_WINDOWING_X11
   GdkScreen* screen = gtk_window_get_screen(window);
@@ -59,6 +81,21 @@ static void my_application_activate(GApplication* application) {
 
   fl_register_plugins(FL_PLUGIN_REGISTRY(view));
 
+  // Record the startup prefetch profile once the first frame is on screen.
+  // Engines without FlView::first-frame cannot tell when Dart has rendered,
+  // so they never record one and prefetch nothing.
+  if (g_signal_lookup("first-frame", G_OBJECT_TYPE(view)) != 0) {
+    g_signal_connect(view, "first-frame", G_CALLBACK(first_frame_cb), self);
+  }
+
+  FlBinaryMessenger* messenger =
+      fl_engine_get_binary_messenger(fl_view_get_engine(view));
+  self->drag_drop = drag_drop_new(window, messenger);
+  self->hotkey_manager = hotkey_manager_new(window, messenger);
+  self->latency_tracker = latency_tracker_new(window);
+  self->window_mru = window_mru_new(window, messenger);
+  self->window_ops = window_ops_new(window, messenger);
+
   gtk_widget_grab_focus(GTK_WIDGET(view));
 }
 
@@ -85,6 +122,11 @@ static gboolean my_application_local_command_line(GApplication* application, gch
 static void my_application_dispose(GObject* object) {
   MyApplication* self = MY_APPLICATION(object);
   g_clear_pointer(&self->dart_entrypoint_arguments, g_strfreev);
+  g_clear_object(&self->drag_drop);
+  g_clear_object(&self->hotkey_manager);
+  g_clear_object(&self->latency_tracker);
+  g_clear_object(&self->window_mru);
+  g_clear_object(&self->window_ops);
   G_OBJECT_CLASS(my_application_parent_class)->dispose(object);
 }
 
@@ -0,0 +1,378 @@
+#include "startup_prefetch.h"
+
+#include <fcntl.h>
+#include <glib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr char kProfileName[] = "startup_prefetch.profile";
+
+// Files loaded at startup, relative to the executable's directory. See the
+// install rules in CMakeLists.txt.
+const char* const kBundleFiles[] = {
+    "lib/libapp.so",
+    "lib/libflutter_linux_gtk.so",
+    "data/icudtl.dat",
+};
+constexpr char kAssetsDir[] = "data/flutter_assets";
+
+// A cold start finds at most this share of the bundle's pages already
+// resident: little beyond what the dynamic loader touched before main().
+// When more is resident, the run cannot tell which pages startup needs.
+constexpr double kMaxColdResidentFraction = 0.5;
+
+// Resident ranges separated by fewer pages than this are merged, trading a
+// little extra I/O for fewer readahead calls.
+constexpr gint64 kMergeGapPages = 16;
+
+struct ByteRange {
+  gint64 offset;
+  gint64 length;
+};
+
+// Pages of one file touched by a previous run. |size| and |mtime| detect
+// files replaced by a new build.
+struct ProfileEntry {
+  std::string path;
+  gint64 size;
+  gint64 mtime;
+  std::vector<ByteRange> ranges;
+};
+
+}  // namespace
+
+static GThread* prefetch_thread = nullptr;
+
+// Records the profile once the first frame is up, see
+// startup_prefetch_first_frame().
+static GThread* record_thread = nullptr;
+
+// Set by the prefetch thread; read after it has been joined.
+static gboolean profile_up_to_date = FALSE;
+
+// Whether the bundle was mostly uncached when the prefetch thread started,
+// and which pages of each bundle file were resident then, by path relative
+// to the bundle. Taken only when the profile is to be recorded. Set by the
+// prefetch thread; read after it has been joined.
+static gboolean started_cold = FALSE;
+static std::map<std::string, std::vector<unsigned char>> start_residency;
+
+static gchar* get_bundle_dir() {
+  g_autofree gchar* executable = g_file_read_link("/proc/self/exe", nullptr);
+  return executable != nullptr ? g_path_get_dirname(executable) : nullptr;
+}
+
+static gchar* get_profile_path() {
+  return g_build_filename(g_get_user_cache_dir(), APPLICATION_ID, kProfileName,
+                          nullptr);
+}
+
+// Parses the profile, one file per line:
+//   <path>\t<size>\t<mtime>\t<offset>+<length>,<offset>+<length>,...
+static gboolean load_profile(const gchar* profile_path,
+                             std::vector<ProfileEntry>* entries) {
+  g_autofree gchar* contents = nullptr;
+  if (!g_file_get_contents(profile_path, &contents, nullptr, nullptr)) {
+    return FALSE;
+  }
+  g_auto(GStrv) lines = g_strsplit(contents, "\n", -1);
+  for (gchar** line = lines; *line != nullptr; line++) {
+    if (**line == '\0') {
+      continue;
+    }
+    g_auto(GStrv) fields = g_strsplit(*line, "\t", 4);
+    if (g_strv_length(fields) != 4) {
+      return FALSE;
+    }
+    ProfileEntry entry;
+    entry.path = fields[0];
+    entry.size = g_ascii_strtoll(fields[1], nullptr, 10);
+    entry.mtime = g_ascii_strtoll(fields[2], nullptr, 10);
+    g_auto(GStrv) ranges = g_strsplit(fields[3], ",", -1);
+    for (gchar** range = ranges; *range != nullptr; range++) {
+      gchar* end = nullptr;
+      gint64 offset = g_ascii_strtoll(*range, &end, 10);
+      if (end == nullptr || *end != '+') {
+        continue;
+      }
+      entry.ranges.push_back({offset, g_ascii_strtoll(end + 1, nullptr, 10)});
+    }
+    entries->push_back(entry);
+  }
+  return !entries->empty();
+}
+
+static void list_assets(const gchar* bundle_dir, const gchar* relative_dir,
+                        std::vector<std::string>* paths) {
+  g_autofree gchar* dir_path =
+      g_build_filename(bundle_dir, relative_dir, nullptr);
+  g_autoptr(GDir) dir = g_dir_open(dir_path, 0, nullptr);
+  if (dir == nullptr) {
+    return;
+  }
+  const gchar* name = nullptr;
+  while ((name = g_dir_read_name(dir)) != nullptr) {
+    g_autofree gchar* relative_path =
+        g_build_filename(relative_dir, name, nullptr);
+    g_autofree gchar* path = g_build_filename(bundle_dir, relative_path,
+                                              nullptr);
+    if (g_file_test(path, G_FILE_TEST_IS_DIR)) {
+      list_assets(bundle_dir, relative_path, paths);
+    } else {
+      paths->push_back(relative_path);
+    }
+  }
+}
+
+// Lists the bundle files loaded at startup, relative to |bundle_dir|. Debug
+// bundles have no AOT library, so only files that exist are listed.
+static std::vector<std::string> list_bundle_files(const gchar* bundle_dir) {
+  std::vector<std::string> paths;
+  for (const char* file : kBundleFiles) {
+    g_autofree gchar* path = g_build_filename(bundle_dir, file, nullptr);
+    if (g_file_test(path, G_FILE_TEST_EXISTS)) {
+      paths.push_back(file);
+    }
+  }
+  list_assets(bundle_dir, kAssetsDir, &paths);
+  return paths;
+}
+
+// Reads which pages of the file at |path| are resident into |resident|,
+// one byte per page with bit 0 set for resident pages. Returns the file's
+// status through |info|, or FALSE if it cannot be read.
+static gboolean get_residency(const gchar* path, struct stat* info,
+                              std::vector<unsigned char>* resident) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return FALSE;
+  }
+  if (fstat(fd, info) != 0) {
+    close(fd);
+    return FALSE;
+  }
+  gint64 page_size = sysconf(_SC_PAGESIZE);
+  resident->assign((info->st_size + page_size - 1) / page_size, 0);
+  if (info->st_size > 0) {
+    void* data = mmap(nullptr, info->st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED ||
+        mincore(data, info->st_size, resident->data()) != 0) {
+      resident->assign(resident->size(), 0);
+    }
+    if (data != MAP_FAILED) {
+      munmap(data, info->st_size);
+    }
+  }
+  close(fd);
+  return TRUE;
+}
+
+// Records which pages of |files| are resident into start_residency, and
+// whether few enough are for the run to be a cold start.
+static void snapshot_residency(const gchar* bundle_dir,
+                               const std::vector<std::string>& files) {
+  gint64 total_pages = 0;
+  gint64 resident_pages = 0;
+  for (const std::string& file : files) {
+    g_autofree gchar* path =
+        g_build_filename(bundle_dir, file.c_str(), nullptr);
+    struct stat info;
+    std::vector<unsigned char> resident;
+    if (!get_residency(path, &info, &resident)) {
+      continue;
+    }
+    for (unsigned char page : resident) {
+      resident_pages += page & 1;
+    }
+    total_pages += resident.size();
+    start_residency[file] = std::move(resident);
+  }
+  started_cold = resident_pages <= total_pages * kMaxColdResidentFraction;
+}
+
+// Returns whether |entries| match the bundle's current |files|: every
+// profiled file is unchanged, and no file is missing from the profile, as
+// new assets added by a build are.
+static gboolean profile_matches(const gchar* bundle_dir,
+                                const std::vector<ProfileEntry>& entries,
+                                const std::vector<std::string>& files) {
+  std::set<std::string> profiled;
+  for (const ProfileEntry& entry : entries) {
+    g_autofree gchar* path =
+        g_build_filename(bundle_dir, entry.path.c_str(), nullptr);
+    struct stat info;
+    if (stat(path, &info) != 0 || info.st_size != entry.size ||
+        info.st_mtime != entry.mtime) {
+      return FALSE;
+    }
+    profiled.insert(entry.path);
+  }
+  for (const std::string& file : files) {
+    if (profiled.count(file) == 0) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+static gpointer prefetch_thread_func(gpointer data) {
+  g_autofree gchar* bundle_dir = get_bundle_dir();
+  if (bundle_dir == nullptr) {
+    return nullptr;
+  }
+  g_autofree gchar* profile_path = get_profile_path();
+  std::vector<std::string> files = list_bundle_files(bundle_dir);
+  std::vector<ProfileEntry> entries;
+  if (!load_profile(profile_path, &entries) ||
+      !profile_matches(bundle_dir, entries, files)) {
+    // The profile is to be recorded: note what is resident before startup
+    // touches the bundle, and prefetch nothing so that what becomes
+    // resident is what startup read. The engine only opens the bundle once
+    // the window is created, well after this; pages the dynamic loader read
+    // before main() are resident already, and prefetching them would not
+    // help anyway.
+    snapshot_residency(bundle_dir, files);
+    return nullptr;
+  }
+
+  for (const ProfileEntry& entry : entries) {
+    g_autofree gchar* path =
+        g_build_filename(bundle_dir, entry.path.c_str(), nullptr);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      continue;
+    }
+    for (const ByteRange& range : entry.ranges) {
+      readahead(fd, range.offset, range.length);
+    }
+    close(fd);
+  }
+  profile_up_to_date = TRUE;
+  return nullptr;
+}
+
+// Appends a profile line for |relative_path| listing the pages that became
+// resident since the prefetch thread started. Files with no such pages still
+// get a line, so that the profile lists every file the bundle had when it
+// was recorded.
+static void record_file(const gchar* bundle_dir,
+                        const std::string& relative_path, GString* profile) {
+  g_autofree gchar* path =
+      g_build_filename(bundle_dir, relative_path.c_str(), nullptr);
+  struct stat info;
+  std::vector<unsigned char> resident;
+  if (!get_residency(path, &info, &resident)) {
+    return;
+  }
+  auto before = start_residency.find(relative_path);
+  if (before != start_residency.end() &&
+      before->second.size() == resident.size()) {
+    for (size_t page = 0; page < resident.size(); page++) {
+      resident[page] &= ~before->second[page];
+    }
+  }
+
+  g_string_append_printf(profile, "%s\t%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT
+                         "\t", relative_path.c_str(),
+                         static_cast<gint64>(info.st_size),
+                         static_cast<gint64>(info.st_mtime));
+  gint64 page_size = sysconf(_SC_PAGESIZE);
+  gint64 n_pages = resident.size();
+  gboolean first = TRUE;
+  for (gint64 page = 0; page < n_pages;) {
+    if (!(resident[page] & 1)) {
+      page++;
+      continue;
+    }
+    gint64 start = page;
+    gint64 end = page + 1;
+    for (gint64 next = end; next < n_pages && next - end < kMergeGapPages;
+         next++) {
+      if (resident[next] & 1) {
+        end = next + 1;
+      }
+    }
+    g_string_append_printf(profile, "%s%" G_GINT64_FORMAT "+%" G_GINT64_FORMAT,
+                           first ? "" : ",", start * page_size,
+                           (end - start) * page_size);
+    first = FALSE;
+    page = end;
+  }
+  g_string_append_c(profile, '\n');
+}
+
+static void record_profile() {
+  g_autofree gchar* bundle_dir = get_bundle_dir();
+  if (bundle_dir == nullptr) {
+    return;
+  }
+  g_autoptr(GString) profile = g_string_new(nullptr);
+  for (const std::string& path : list_bundle_files(bundle_dir)) {
+    record_file(bundle_dir, path, profile);
+  }
+
+  g_autofree gchar* profile_path = get_profile_path();
+  g_autofree gchar* profile_dir = g_path_get_dirname(profile_path);
+  g_autoptr(GError) error = nullptr;
+  if (g_mkdir_with_parents(profile_dir, 0700) != 0 ||
+      !g_file_set_contents(profile_path, profile->str, profile->len, &error)) {
+    g_warning("Failed to save startup prefetch profile: %s",
+              error != nullptr ? error->message : g_strerror(errno));
+  }
+}
+
+void startup_prefetch_start() {
+  if (g_strcmp0(g_getenv("STARTUP_PREFETCH"), "0") == 0) {
+    return;
+  }
+  prefetch_thread =
+      g_thread_new("startup-prefetch", prefetch_thread_func, nullptr);
+}
+
+static gpointer record_thread_func(gpointer data) {
+  g_thread_join(prefetch_thread);
+  prefetch_thread = nullptr;
+  // An up-to-date profile is not re-recorded: the pages it prefetched would
+  // all show up as resident and the profile could only grow. Nor is one
+  // recorded from a warm start, such as the first run after a build, which
+  // would list the whole bundle or, with what was resident subtracted,
+  // almost nothing; the next cold start records it instead.
+  if (!profile_up_to_date && started_cold) {
+    record_profile();
+  }
+  return nullptr;
+}
+
+void startup_prefetch_first_frame() {
+  if (prefetch_thread == nullptr || record_thread != nullptr) {
+    return;
+  }
+  // mincore() over the whole bundle takes a while; keep it off the GTK
+  // thread that is busy presenting the first frames.
+  record_thread =
+      g_thread_new("startup-profile", record_thread_func, nullptr);
+}
+
+void startup_prefetch_finish() {
+  if (record_thread != nullptr) {
+    g_thread_join(record_thread);
+    record_thread = nullptr;
+  }
+  // Without a first frame, as when the application exits during startup,
+  // there is nothing meaningful to record.
+  if (prefetch_thread != nullptr) {
+    g_thread_join(prefetch_thread);
+    prefetch_thread = nullptr;
+  }
+}
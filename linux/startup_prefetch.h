@@ -0,0 +1,42 @@
+#ifndef FLUTTER_STARTUP_PREFETCH_H_
+#define FLUTTER_STARTUP_PREFETCH_H_
+
+/**
+ * startup_prefetch_start:
+ *
+ * Starts reading the bundle's AOT library, engine library, ICU data and
+ * flutter_assets into the page cache on a background thread, so that
+ * loading them while GTK initializes does not stall on disk I/O. Only the
+ * pages listed in the access profile recorded by a previous run are read.
+ * If the profile is missing or stale, nothing is read; instead the pages
+ * already resident are noted, so that the profile can be recorded from
+ * what startup reads.
+ *
+ * Set `STARTUP_PREFETCH=0` to disable prefetching, e.g. to compare cold
+ * start times; test/startup_benchmark.sh does so with dropped page caches.
+ */
+void startup_prefetch_start();
+
+/**
+ * startup_prefetch_first_frame:
+ *
+ * Call once the first Flutter frame has been presented, when the pages
+ * needed for startup have been loaded but little else has. If the profile
+ * is missing or stale (a profiled file changed, disappeared, or a new file
+ * such as an added asset is not in it), records which pages of the bundle's
+ * files became resident since startup_prefetch_start() for the next run, on
+ * a background thread. Warm starts, which found most of the bundle resident
+ * already, record nothing; the next cold start does. Later calls do
+ * nothing.
+ */
+void startup_prefetch_first_frame();
+
+/**
+ * startup_prefetch_finish:
+ *
+ * Waits for the prefetch and any profile recording to complete. Call once
+ * the application has finished running.
+ */
+void startup_prefetch_finish();
+
+#endif  // FLUTTER_STARTUP_PREFETCH_H_
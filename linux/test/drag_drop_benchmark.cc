@@ -0,0 +1,128 @@
+// Streams a 1 GiB dropped file through the native read path and reports the
+// process's peak RSS, which should stay near one chunk however large the
+// file is. Reads into a caller-owned buffer through FFI and the zero-copy
+// mapping are measured alongside for comparison.
+//
+// Run the binary directly; it needs no display.
+
+#include "drag_drop.h"
+
+#include <benchmark/benchmark.h>
+#include <glib/gstdio.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kFileSize = 1ull << 30;
+constexpr uint64_t kChunkSize = 4 * 1024 * 1024;
+
+gchar* test_file = nullptr;
+
+// Writes the test file once. It is filled with data rather than left sparse
+// so that reads go through real page cache pages.
+const gchar* GetTestFile() {
+  if (test_file == nullptr) {
+    int fd = g_file_open_tmp("drag_drop_benchmark-XXXXXX", &test_file, nullptr);
+    if (fd < 0) {
+      abort();
+    }
+    std::vector<char> block(kChunkSize, 'x');
+    for (uint64_t written = 0; written < kFileSize; written += block.size()) {
+      if (write(fd, block.data(), block.size()) !=
+          static_cast<ssize_t>(block.size())) {
+        abort();
+      }
+    }
+    close(fd);
+  }
+  return test_file;
+}
+
+double PeakRssMib() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss / 1024.0;
+}
+
+// What Dart's "read" loop costs natively: every chunk is copied into a new
+// FlValue, which the engine frees once it has been encoded.
+void BM_ReadDroppedFile(benchmark::State& state) {
+  DragDrop* drag_drop = drag_drop_new(nullptr, nullptr);
+  int64_t id = drag_drop_add_file(drag_drop, GetTestFile(), nullptr);
+  double rss_before = PeakRssMib();
+  for (auto _ : state) {
+    for (uint64_t offset = 0; offset < kFileSize; offset += kChunkSize) {
+      FlValue* chunk =
+          drag_drop_read_chunk(drag_drop, id, offset, kChunkSize, nullptr);
+      benchmark::DoNotOptimize(fl_value_get_uint8_list(chunk));
+      fl_value_unref(chunk);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * kFileSize);
+  state.counters["peak_rss_mib"] = PeakRssMib();
+  state.counters["peak_rss_growth_mib"] = PeakRssMib() - rss_before;
+  g_object_unref(drag_drop);
+}
+BENCHMARK(BM_ReadDroppedFile)->Unit(benchmark::kMillisecond)->Iterations(3);
+
+// What a Dart isolate reading through FFI costs: chunks land straight in a
+// buffer it owns and reuses.
+void BM_ReadDroppedFileInto(benchmark::State& state) {
+  DragDrop* drag_drop = drag_drop_new(nullptr, nullptr);
+  int64_t id = drag_drop_add_file(drag_drop, GetTestFile(), nullptr);
+  double rss_before = PeakRssMib();
+  std::vector<uint8_t> buffer(kChunkSize);
+  for (auto _ : state) {
+    for (uint64_t offset = 0; offset < kFileSize; offset += kChunkSize) {
+      benchmark::DoNotOptimize(
+          drag_drop_read_into(id, offset, buffer.data(), buffer.size()));
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * kFileSize);
+  state.counters["peak_rss_mib"] = PeakRssMib();
+  state.counters["peak_rss_growth_mib"] = PeakRssMib() - rss_before;
+  g_object_unref(drag_drop);
+}
+BENCHMARK(BM_ReadDroppedFileInto)->Unit(benchmark::kMillisecond)->Iterations(3);
+
+// Touches every page of the FFI mapping. Mapped pages count towards RSS
+// until the item is released.
+void BM_MapDroppedFile(benchmark::State& state) {
+  DragDrop* drag_drop = drag_drop_new(nullptr, nullptr);
+  int64_t id = drag_drop_add_file(drag_drop, GetTestFile(), nullptr);
+  double rss_before = PeakRssMib();
+  const uint8_t* data = nullptr;
+  uint64_t size = 0;
+  if (!drag_drop_map_item(id, &data, &size)) {
+    state.SkipWithError("drag_drop_map_item failed");
+  }
+  long page_size = sysconf(_SC_PAGESIZE);
+  for (auto _ : state) {
+    unsigned int sum = 0;
+    for (uint64_t offset = 0; offset < size; offset += page_size) {
+      sum += data[offset];
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+  state.counters["peak_rss_mib"] = PeakRssMib();
+  state.counters["peak_rss_growth_mib"] = PeakRssMib() - rss_before;
+  g_object_unref(drag_drop);
+}
+BENCHMARK(BM_MapDroppedFile)->Unit(benchmark::kMillisecond)->Iterations(3);
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  if (test_file != nullptr) {
+    g_unlink(test_file);
+    g_free(test_file);
+  }
+  return 0;
+}
@@ -0,0 +1,250 @@
+// Drives HotkeyManager's X event filter with chords injected through XTest.
+// Needs an X server; ctest runs it under xvfb-run.
+
+#include "hotkey_manager.h"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/XTest.h>
+#include <X11/keysym.h>
+#include <gtest/gtest.h>
+#include <gtk/gtk.h>
+
+#include <vector>
+
+#include "test_util.h"
+
+namespace {
+
+using test_util::ReportLatencies;
+using test_util::Spin;
+using test_util::SpinUntil;
+
+// Slightly longer than the manager's chord timeout.
+constexpr int kPastChordTimeoutMs = 1200;
+
+// How long to wait for an activation that should, or should not, happen.
+constexpr int kActivationWaitMs = 500;
+
+constexpr int kLatencySamples = 200;
+
+struct Activation {
+  gint64 id;
+  gint64 monotonic_time;
+};
+
+class HotkeyManagerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    window_ = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+    g_signal_connect(window_, "delete-event", G_CALLBACK(delete_event_cb),
+                     this);
+    // Window actions such as gtk_window_close() do nothing on a window that
+    // has not been realized.
+    gtk_widget_show(GTK_WIDGET(window_));
+    manager_ = hotkey_manager_new(window_, nullptr);
+    g_signal_connect(manager_, "activated", G_CALLBACK(activated_cb), this);
+
+    // Keys are injected on a connection of their own, like a real keyboard
+    // would be, so the manager only sees them through its grabs.
+    injector_ = XOpenDisplay(nullptr);
+    ASSERT_NE(injector_, nullptr);
+  }
+
+  void TearDown() override {
+    if (injector_ != nullptr) {
+      XCloseDisplay(injector_);
+    }
+    g_clear_object(&manager_);
+    gtk_widget_destroy(GTK_WIDGET(window_));
+  }
+
+  void Bind(gint64 id, const gchar* chord, const gchar* action) {
+    g_autoptr(GError) error = nullptr;
+    ASSERT_TRUE(hotkey_manager_bind(manager_, id, chord, action, &error))
+        << error->message;
+  }
+
+  void Key(KeySym keysym, bool press) {
+    XTestFakeKeyEvent(injector_, XKeysymToKeycode(injector_, keysym), press,
+                      CurrentTime);
+    XFlush(injector_);
+  }
+
+  void Tap(KeySym keysym) {
+    Key(keysym, true);
+    Key(keysym, false);
+  }
+
+  void TapWithControl(KeySym keysym) {
+    Key(XK_Control_L, true);
+    Tap(keysym);
+    Key(XK_Control_L, false);
+  }
+
+  bool WaitForActivations(size_t count) {
+    return SpinUntil([&] { return activations_.size() >= count; },
+                     kActivationWaitMs);
+  }
+
+  static void activated_cb(HotkeyManager* manager, gint64 id, guint time,
+                           gpointer user_data) {
+    HotkeyManagerTest* self = static_cast<HotkeyManagerTest*>(user_data);
+    self->activations_.push_back({id, g_get_monotonic_time()});
+  }
+
+  static gboolean delete_event_cb(GtkWidget* widget, GdkEvent* event,
+                                  gpointer user_data) {
+    static_cast<HotkeyManagerTest*>(user_data)->close_requests_++;
+    return TRUE;
+  }
+
+  GtkWindow* window_ = nullptr;
+  HotkeyManager* manager_ = nullptr;
+  Display* injector_ = nullptr;
+  std::vector<Activation> activations_;
+  int close_requests_ = 0;
+};
+
+TEST_F(HotkeyManagerTest, MatchRunsAction) {
+  Bind(1, "<Control>w 1", "close");
+
+  TapWithControl(XK_w);
+  Tap(XK_1);
+
+  ASSERT_TRUE(WaitForActivations(1));
+  EXPECT_EQ(activations_[0].id, 1);
+  // gtk_window_close() delivers its delete-event from the main loop.
+  EXPECT_TRUE(SpinUntil([&] { return close_requests_ == 1; },
+                        kActivationWaitMs));
+}
+
+TEST_F(HotkeyManagerTest, ModifierHeldThroughChordMatches) {
+  Bind(1, "<Control>w 1", "notify");
+
+  Key(XK_Control_L, true);
+  Tap(XK_w);
+  Tap(XK_1);
+  Key(XK_Control_L, false);
+
+  ASSERT_TRUE(WaitForActivations(1));
+  EXPECT_EQ(activations_[0].id, 1);
+}
+
+TEST_F(HotkeyManagerTest, WrongKeyCancelsChord) {
+  Bind(1, "<Control>w 1", "notify");
+
+  TapWithControl(XK_w);
+  Tap(XK_x);
+  Tap(XK_1);
+
+  EXPECT_FALSE(WaitForActivations(1));
+}
+
+TEST_F(HotkeyManagerTest, WrongKeyRestartsChord) {
+  Bind(1, "<Control>w 1", "notify");
+  Bind(2, "<Control>q 2", "notify");
+
+  TapWithControl(XK_w);
+  TapWithControl(XK_q);
+  Tap(XK_2);
+
+  ASSERT_TRUE(WaitForActivations(1));
+  EXPECT_EQ(activations_[0].id, 2);
+  EXPECT_EQ(activations_.size(), 1u);
+}
+
+TEST_F(HotkeyManagerTest, TimeoutResetsChord) {
+  Bind(1, "<Control>w 1", "notify");
+
+  TapWithControl(XK_w);
+  Spin(kPastChordTimeoutMs);
+  Tap(XK_1);
+  EXPECT_FALSE(WaitForActivations(1));
+
+  // The manager is armed again once the stale chord is gone.
+  TapWithControl(XK_w);
+  Tap(XK_1);
+  ASSERT_TRUE(WaitForActivations(1));
+  EXPECT_EQ(activations_[0].id, 1);
+}
+
+TEST_F(HotkeyManagerTest, UnbindReleasesChord) {
+  Bind(1, "<Control>w 1", "notify");
+  hotkey_manager_unbind(manager_, 1);
+
+  TapWithControl(XK_w);
+  Tap(XK_1);
+
+  EXPECT_FALSE(WaitForActivations(1));
+}
+
+TEST_F(HotkeyManagerTest, RejectsAmbiguousChord) {
+  Bind(1, "<Control>w 1", "notify");
+
+  g_autoptr(GError) error = nullptr;
+  EXPECT_FALSE(hotkey_manager_bind(manager_, 2, "<Control>w", nullptr, &error));
+  EXPECT_TRUE(g_error_matches(error, HOTKEY_MANAGER_ERROR,
+                              HOTKEY_MANAGER_ERROR_CONFLICT));
+}
+
+TEST_F(HotkeyManagerTest, RejectsKeyMissingFromLayout) {
+  g_autoptr(GError) error = nullptr;
+  EXPECT_FALSE(
+      hotkey_manager_bind(manager_, 1, "<Control>Thai_kokai", nullptr, &error));
+  EXPECT_TRUE(g_error_matches(error, HOTKEY_MANAGER_ERROR,
+                              HOTKEY_MANAGER_ERROR_INVALID));
+}
+
+// A layout change that loses the key of one chord leaves the others bound.
+TEST_F(HotkeyManagerTest, LayoutChangeKeepsMappedHotkeys) {
+  Bind(1, "<Control>w 1", "notify");
+  Bind(2, "<Control>q 2", "notify");
+
+  KeyCode q = XKeysymToKeycode(injector_, XK_q);
+  ASSERT_NE(q, 0);
+  int keysyms_per_keycode = 0;
+  KeySym* saved = XGetKeyboardMapping(injector_, q, 1, &keysyms_per_keycode);
+  std::vector<KeySym> unmapped(keysyms_per_keycode, NoSymbol);
+  XChangeKeyboardMapping(injector_, q, keysyms_per_keycode, unmapped.data(),
+                         1);
+  XSync(injector_, False);
+  // Let the manager see the MappingNotify and re-grab.
+  Spin(100);
+
+  TapWithControl(XK_w);
+  Tap(XK_1);
+  bool activated = WaitForActivations(1);
+
+  XChangeKeyboardMapping(injector_, q, keysyms_per_keycode, saved, 1);
+  XFree(saved);
+  XSync(injector_, False);
+  Spin(100);
+
+  ASSERT_TRUE(activated);
+  EXPECT_EQ(activations_[0].id, 1);
+}
+
+// Reports the time from injecting the chord's last key to the action having
+// run, as seen by the X server round trip plus the manager's matching.
+TEST_F(HotkeyManagerTest, PressToActionLatency) {
+  Bind(1, "<Control>w 1", "notify");
+
+  std::vector<gint64> latencies;
+  for (int i = 0; i < kLatencySamples; i++) {
+    activations_.clear();
+    TapWithControl(XK_w);
+    gint64 start = g_get_monotonic_time();
+    Tap(XK_1);
+    ASSERT_TRUE(WaitForActivations(1)) << "sample " << i;
+    latencies.push_back(activations_[0].monotonic_time - start);
+  }
+
+  ReportLatencies("press-to-action latency", &latencies);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  gdk_set_allowed_backends("x11");
+  return test_util::RunDisplayTests(argc, argv);
+}
@@ -0,0 +1,162 @@
+// Unit tests for LatencyHistogram. Needs no display.
+
+#include "latency_histogram.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+namespace {
+
+class LatencyHistogramTest : public ::testing::Test {
+ protected:
+  // Zero-initialized, as the tracker's static histograms are.
+  void SetUp() override { histogram_ = std::make_unique<LatencyHistogram>(); }
+
+  void Record(int64_t value_us, int times = 1) {
+    for (int i = 0; i < times; i++) {
+      latency_histogram_record(histogram_.get(), value_us);
+    }
+  }
+
+  int64_t Percentile(double percentile) {
+    return latency_histogram_value_at_percentile(histogram_.get(),
+                                                 percentile);
+  }
+
+  // Returns what a histogram holding only |value_us| reports for it.
+  static int64_t Reported(int64_t value_us) {
+    auto histogram = std::make_unique<LatencyHistogram>();
+    latency_histogram_record(histogram.get(), value_us);
+    return latency_histogram_value_at_percentile(histogram.get(), 100.0);
+  }
+
+  std::unique_ptr<LatencyHistogram> histogram_;
+};
+
+// Checks that |actual| is a bucket upper bound for |expected|: never below
+// it, and at most 1/64 (under 1.6%) above it.
+void ExpectWithinBucket(int64_t actual, int64_t expected) {
+  EXPECT_GE(actual, expected);
+  EXPECT_LE(actual - expected, expected / 64) << "for " << expected;
+}
+
+TEST_F(LatencyHistogramTest, EmptyReportsZero) {
+  EXPECT_EQ(latency_histogram_total_count(histogram_.get()), 0u);
+  EXPECT_EQ(latency_histogram_max(histogram_.get()), 0);
+  EXPECT_EQ(Percentile(50.0), 0);
+  EXPECT_EQ(Percentile(100.0), 0);
+}
+
+TEST_F(LatencyHistogramTest, ValuesBelowSubBucketCountAreExact) {
+  for (int64_t value = 0; value < LATENCY_HISTOGRAM_SUB_BUCKETS; value++) {
+    EXPECT_EQ(Reported(value), value);
+  }
+}
+
+TEST_F(LatencyHistogramTest, ExactRangeKeepsDistinctValuesApart) {
+  for (int64_t value = 0; value < LATENCY_HISTOGRAM_SUB_BUCKETS; value++) {
+    Record(value);
+  }
+
+  EXPECT_EQ(latency_histogram_total_count(histogram_.get()),
+            static_cast<uint64_t>(LATENCY_HISTOGRAM_SUB_BUCKETS));
+  EXPECT_EQ(Percentile(0.0), 0);
+  EXPECT_EQ(Percentile(50.0), 63);
+  EXPECT_EQ(Percentile(100.0), 127);
+}
+
+// Each power of two from the sub-bucket count up starts a new range of
+// buckets twice as wide as the previous one.
+TEST_F(LatencyHistogramTest, PowersOfTwoStartNewBuckets) {
+  for (int bit = 7; bit < 26; bit++) {
+    int64_t power = INT64_C(1) << bit;
+    int64_t width = INT64_C(1) << (bit - 6);
+    SCOPED_TRACE(power);
+
+    // The last value below a power of two ends its bucket.
+    EXPECT_EQ(Reported(power - 1), power - 1);
+    // The power of two opens a bucket of its own range's width.
+    EXPECT_EQ(Reported(power), power + width - 1);
+    EXPECT_EQ(Reported(power + width - 1), power + width - 1);
+    EXPECT_EQ(Reported(power + width), power + 2 * width - 1);
+  }
+}
+
+TEST_F(LatencyHistogramTest, RelativeErrorStaysUnderBound) {
+  for (int64_t value = 1; value < (1 << 16); value++) {
+    ExpectWithinBucket(Reported(value), value);
+  }
+  for (int64_t value = 1 << 16; value <= LATENCY_HISTOGRAM_MAX_US;
+       value = value * 5 / 4 + 1) {
+    ExpectWithinBucket(Reported(value), value);
+  }
+}
+
+TEST_F(LatencyHistogramTest, ClampsAboveMax) {
+  EXPECT_EQ(Reported(LATENCY_HISTOGRAM_MAX_US), LATENCY_HISTOGRAM_MAX_US);
+
+  Record(LATENCY_HISTOGRAM_MAX_US + 1);
+  Record(INT64_MAX);
+
+  EXPECT_EQ(latency_histogram_total_count(histogram_.get()), 2u);
+  EXPECT_EQ(latency_histogram_max(histogram_.get()), LATENCY_HISTOGRAM_MAX_US);
+  EXPECT_EQ(Percentile(0.0), LATENCY_HISTOGRAM_MAX_US);
+  EXPECT_EQ(Percentile(100.0), LATENCY_HISTOGRAM_MAX_US);
+}
+
+TEST_F(LatencyHistogramTest, ClampsNegativeToZero) {
+  Record(-1);
+  Record(INT64_MIN);
+
+  EXPECT_EQ(latency_histogram_total_count(histogram_.get()), 2u);
+  EXPECT_EQ(latency_histogram_max(histogram_.get()), 0);
+  EXPECT_EQ(Percentile(100.0), 0);
+}
+
+TEST_F(LatencyHistogramTest, UniformDistributionPercentiles) {
+  for (int64_t value = 1; value <= 1000; value++) {
+    Record(value);
+  }
+
+  EXPECT_EQ(latency_histogram_max(histogram_.get()), 1000);
+  EXPECT_EQ(Percentile(0.0), 1);
+  ExpectWithinBucket(Percentile(50.0), 500);
+  ExpectWithinBucket(Percentile(90.0), 900);
+  ExpectWithinBucket(Percentile(99.0), 990);
+  ExpectWithinBucket(Percentile(99.9), 999);
+  ExpectWithinBucket(Percentile(100.0), 1000);
+}
+
+// A few slow frames among many fast ones only show in the high percentiles.
+TEST_F(LatencyHistogramTest, BimodalDistributionPercentiles) {
+  Record(8000, 900);
+  Record(50000, 100);
+
+  ExpectWithinBucket(Percentile(50.0), 8000);
+  ExpectWithinBucket(Percentile(90.0), 8000);
+  ExpectWithinBucket(Percentile(90.1), 50000);
+  ExpectWithinBucket(Percentile(99.0), 50000);
+}
+
+TEST_F(LatencyHistogramTest, PercentileIsClampedToRange) {
+  Record(10);
+  Record(20);
+
+  EXPECT_EQ(Percentile(-5.0), 10);
+  EXPECT_EQ(Percentile(150.0), 20);
+}
+
+TEST_F(LatencyHistogramTest, ResetDiscardsSamples) {
+  Record(1000, 10);
+  latency_histogram_reset(histogram_.get());
+
+  EXPECT_EQ(latency_histogram_total_count(histogram_.get()), 0u);
+  EXPECT_EQ(latency_histogram_max(histogram_.get()), 0);
+  EXPECT_EQ(Percentile(50.0), 0);
+
+  Record(42);
+  EXPECT_EQ(Percentile(50.0), 42);
+}
+
+}  // namespace
@@ -0,0 +1,35 @@
+#!/bin/sh
+# Runs a test binary against a private headless Weston compositor.
+#
+# Usage: run_under_weston.sh <weston> <test> [args...]
+
+set -eu
+
+weston="$1"
+shift
+
+runtime_dir="$(mktemp -d)"
+chmod 700 "$runtime_dir"
+socket="weston-test-$$"
+
+XDG_RUNTIME_DIR="$runtime_dir" "$weston" --backend=headless-backend.so \
+  --socket="$socket" --idle-time=0 >"$runtime_dir/weston.log" 2>&1 &
+weston_pid=$!
+trap 'kill "$weston_pid" 2>/dev/null; wait "$weston_pid" 2>/dev/null; rm -rf "$runtime_dir"' EXIT
+
+# Wait up to 5 s for the compositor socket.
+tries=50
+while [ ! -S "$runtime_dir/$socket" ]; do
+  tries=$((tries - 1))
+  if [ "$tries" -eq 0 ] || ! kill -0 "$weston_pid" 2>/dev/null; then
+    echo "Weston failed to start:" >&2
+    cat "$runtime_dir/weston.log" >&2
+    exit 1
+  fi
+  sleep 0.1
+done
+
+status=0
+XDG_RUNTIME_DIR="$runtime_dir" WAYLAND_DISPLAY="$socket" GDK_BACKEND=wayland \
+  "$@" || status=$?
+exit "$status"
@@ -0,0 +1,61 @@
+#!/bin/sh
+# Times cold starts of the bundled application with and without the startup
+# prefetch, dropping the page cache before every run. Each run lasts until
+# the first frame has been presented, which needs a bundle configured with
+# -DSTARTUP_BENCHMARK=ON; see STARTUP_BENCHMARK in CMakeLists.txt.
+#
+# Usage: startup_benchmark.sh <bundle executable> [runs]
+#
+# Must run as root (to write /proc/sys/vm/drop_caches) inside a graphical
+# session. Exits with 77 when it cannot drop caches.
+
+set -eu
+
+executable="$1"
+runs="${2:-10}"
+
+if [ ! -w /proc/sys/vm/drop_caches ]; then
+  echo "Cannot drop the page cache; run as root." >&2
+  exit 77
+fi
+
+drop_caches() {
+  sync
+  echo 3 >/proc/sys/vm/drop_caches
+}
+
+# Prints the run time in milliseconds of a cold start. Arguments are extra
+# environment assignments.
+cold_start() {
+  drop_caches
+  start=$(date +%s%N)
+  env "$@" "$executable" >/dev/null 2>&1
+  end=$(date +%s%N)
+  echo $(((end - start) / 1000000))
+}
+
+median() {
+  sort -n | awk '{ v[NR] = $1 }
+    END { print (NR % 2) ? v[(NR + 1) / 2] : (v[NR / 2] + v[NR / 2 + 1]) / 2 }'
+}
+
+# A first cold run records the access profile that later runs prefetch.
+cold_start STARTUP_PREFETCH=1 >/dev/null
+
+baseline=""
+prefetch=""
+i=0
+while [ "$i" -lt "$runs" ]; do
+  # Alternate the two configurations so drift affects both alike.
+  baseline="$baseline $(cold_start STARTUP_PREFETCH=0)"
+  prefetch="$prefetch $(cold_start STARTUP_PREFETCH=1)"
+  i=$((i + 1))
+done
+
+baseline_ms=$(echo "$baseline" | tr ' ' '\n' | grep . | median)
+prefetch_ms=$(echo "$prefetch" | tr ' ' '\n' | grep . | median)
+echo "cold start to first frame, median of $runs runs:"
+echo "  without prefetch: ${baseline_ms} ms"
+echo "  with prefetch:    ${prefetch_ms} ms"
+awk -v b="$baseline_ms" -v p="$prefetch_ms" \
+  'BEGIN { if (b > 0) printf "  gain:             %.1f%%\n", (b - p) * 100 / b }'
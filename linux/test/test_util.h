@@ -0,0 +1,67 @@
+#ifndef FLUTTER_TEST_TEST_UTIL_H_
+#define FLUTTER_TEST_TEST_UTIL_H_
+
+// Harness shared by the tests that run against a display server.
+
+#include <gtest/gtest.h>
+#include <gtk/gtk.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+namespace test_util {
+
+// Runs the main loop until |done| holds or |timeout_ms| elapses. Returns
+// the final value of |done|.
+inline bool SpinUntil(const std::function<bool()>& done, int timeout_ms) {
+  gint64 deadline =
+      g_get_monotonic_time() + timeout_ms * G_TIME_SPAN_MILLISECOND;
+  while (!done() && g_get_monotonic_time() < deadline) {
+    g_main_context_iteration(nullptr, FALSE);
+    g_usleep(100);
+  }
+  return done();
+}
+
+// Runs the main loop for |timeout_ms|.
+inline void Spin(int timeout_ms) {
+  SpinUntil([] { return false; }, timeout_ms);
+}
+
+// Prints the p50, p99 and max of |latencies_us|, which is sorted in place,
+// and records them as properties of the current test so they end up in the
+// XML report.
+inline void ReportLatencies(const gchar* label,
+                            std::vector<gint64>* latencies_us) {
+  if (latencies_us->empty()) {
+    return;
+  }
+  std::sort(latencies_us->begin(), latencies_us->end());
+  gint64 p50 = (*latencies_us)[latencies_us->size() / 2];
+  gint64 p99 = (*latencies_us)[latencies_us->size() * 99 / 100];
+  gint64 max = latencies_us->back();
+  printf("%s over %zu samples: p50 %" G_GINT64_FORMAT
+         " us, p99 %" G_GINT64_FORMAT " us, max %" G_GINT64_FORMAT " us\n",
+         label, latencies_us->size(), p50, p99, max);
+  ::testing::Test::RecordProperty("latency_p50_us", static_cast<int>(p50));
+  ::testing::Test::RecordProperty("latency_p99_us", static_cast<int>(p99));
+  ::testing::Test::RecordProperty("latency_max_us", static_cast<int>(max));
+}
+
+// Initializes GTK and runs all tests. Returns 77, which ctest treats as a
+// skip (see SKIP_RETURN_CODE in CMakeLists.txt), if no display can be
+// opened.
+inline int RunDisplayTests(int argc, char** argv) {
+  if (!gtk_init_check(&argc, &argv)) {
+    fprintf(stderr, "No display, skipping\n");
+    return 77;
+  }
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+}  // namespace test_util
+
+#endif  // FLUTTER_TEST_TEST_UTIL_H_
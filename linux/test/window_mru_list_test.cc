@@ -0,0 +1,238 @@
+// Unit tests for the MRU list logic behind WindowMru. Needs no display.
+
+#include "window_mru_list.h"
+
+#include <gtest/gtest.h>
+
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+namespace {
+
+class WindowMruListTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // The view is too large for the stack and must stay put, as it does
+    // when shared with Dart.
+    view_ = std::make_unique<WindowMruView>();
+    window_mru_list_init(&list_, view_.get());
+  }
+
+  void TearDown() override { window_mru_list_free(&list_); }
+
+  // Returns the listed windows, most recently used first.
+  std::vector<uint64_t> Order() {
+    std::vector<uint64_t> xids;
+    for (int32_t slot = view_->head; slot >= 0;
+         slot = view_->slots[slot].next) {
+      xids.push_back(view_->slots[slot].xid);
+    }
+    return xids;
+  }
+
+  // Returns the listed windows walking from the tail, which checks the
+  // back links.
+  std::vector<uint64_t> ReverseOrder() {
+    std::vector<uint64_t> xids;
+    for (int32_t slot = view_->tail; slot >= 0;
+         slot = view_->slots[slot].prev) {
+      xids.insert(xids.begin(), view_->slots[slot].xid);
+    }
+    return xids;
+  }
+
+  void Touch(std::initializer_list<uint64_t> xids) {
+    for (uint64_t xid : xids) {
+      window_mru_list_touch(&list_, xid);
+    }
+  }
+
+  void Sync(std::initializer_list<uint64_t> xids) {
+    window_mru_list_begin_sync(&list_);
+    for (uint64_t xid : xids) {
+      window_mru_list_mark(&list_, xid);
+    }
+    window_mru_list_end_sync(&list_);
+  }
+
+  uint64_t CursorXid() {
+    return view_->cursor >= 0 ? view_->slots[view_->cursor].xid : 0;
+  }
+
+  std::unique_ptr<WindowMruView> view_;
+  WindowMruList list_ = {};
+};
+
+TEST_F(WindowMruListTest, StartsEmpty) {
+  EXPECT_EQ(view_->count, 0);
+  EXPECT_EQ(view_->head, -1);
+  EXPECT_EQ(view_->tail, -1);
+  EXPECT_EQ(view_->cursor, -1);
+  EXPECT_EQ(window_mru_list_lookup(&list_, 1), -1);
+}
+
+TEST_F(WindowMruListTest, TouchInsertsAtFront) {
+  Touch({1, 2, 3});
+
+  EXPECT_EQ(Order(), (std::vector<uint64_t>{3, 2, 1}));
+  EXPECT_EQ(ReverseOrder(), Order());
+  EXPECT_EQ(view_->count, 3);
+  EXPECT_TRUE(window_mru_list_is_front(&list_, 3));
+  EXPECT_FALSE(window_mru_list_is_front(&list_, 1));
+}
+
+TEST_F(WindowMruListTest, TouchMovesListedWindowToFront) {
+  Touch({1, 2, 3, 1});
+
+  EXPECT_EQ(Order(), (std::vector<uint64_t>{1, 3, 2}));
+  EXPECT_EQ(ReverseOrder(), Order());
+  EXPECT_EQ(view_->count, 3);
+}
+
+TEST_F(WindowMruListTest, AddKeepsListedWindowInPlace) {
+  Touch({1, 2});
+  window_mru_list_add(&list_, 1, true);
+  window_mru_list_add(&list_, 3, false);
+  window_mru_list_add(&list_, 4, true);
+
+  EXPECT_EQ(Order(), (std::vector<uint64_t>{4, 2, 1, 3}));
+  EXPECT_EQ(ReverseOrder(), Order());
+}
+
+TEST_F(WindowMruListTest, FullListEvictsLeastRecentlyUsed) {
+  for (uint64_t xid = 1; xid <= WINDOW_MRU_CAPACITY; xid++) {
+    window_mru_list_touch(&list_, xid);
+  }
+  // Window 1 is now the least recently used; touching it saves it.
+  Touch({1});
+  Touch({WINDOW_MRU_CAPACITY + 1});
+
+  EXPECT_EQ(view_->count, WINDOW_MRU_CAPACITY);
+  EXPECT_EQ(window_mru_list_lookup(&list_, 2), -1);
+  EXPECT_GE(window_mru_list_lookup(&list_, 1), 0);
+  EXPECT_TRUE(window_mru_list_is_front(&list_, WINDOW_MRU_CAPACITY + 1));
+  EXPECT_EQ(view_->slots[view_->tail].xid, 3u);
+}
+
+TEST_F(WindowMruListTest, SyncDropsUnmanagedAndAppendsNewWindows) {
+  Touch({1, 2, 3, 4});
+  Sync({4, 2, 5, 1});
+
+  // Kept windows keep their order; new ones go last.
+  EXPECT_EQ(Order(), (std::vector<uint64_t>{4, 2, 1, 5}));
+  EXPECT_EQ(ReverseOrder(), Order());
+  EXPECT_EQ(view_->count, 4);
+  EXPECT_EQ(window_mru_list_lookup(&list_, 3), -1);
+}
+
+TEST_F(WindowMruListTest, SyncReusesFreedSlots) {
+  Touch({1, 2, 3});
+  for (uint64_t xid = 10; xid < 10 + 2 * WINDOW_MRU_CAPACITY; xid += 2) {
+    // Replace every window, many times over the capacity.
+    Sync({xid, xid + 1});
+  }
+
+  EXPECT_EQ(view_->count, 2);
+  EXPECT_EQ(Order().size(), 2u);
+}
+
+TEST_F(WindowMruListTest, SyncWithEmptyListClearsIt) {
+  Touch({1, 2});
+  Sync({});
+
+  EXPECT_EQ(view_->count, 0);
+  EXPECT_EQ(view_->head, -1);
+  EXPECT_EQ(view_->tail, -1);
+}
+
+TEST_F(WindowMruListTest, RemovingCursorWindowMovesCursorToNext) {
+  Touch({1, 2, 3});  // 3, 2, 1
+  window_mru_view_cycle(view_.get(), 1);
+  ASSERT_EQ(CursorXid(), 2u);
+
+  Sync({1, 3});
+
+  EXPECT_EQ(CursorXid(), 1u);
+}
+
+TEST_F(WindowMruListTest, RemovingCursorWindowAtTailMovesCursorBack) {
+  Touch({1, 2, 3});  // 3, 2, 1
+  window_mru_view_cycle(view_.get(), 2);
+  ASSERT_EQ(CursorXid(), 1u);
+
+  Sync({2, 3});
+
+  EXPECT_EQ(CursorXid(), 2u);
+}
+
+TEST_F(WindowMruListTest, RemovingOnlyWindowClearsCursor) {
+  Touch({1});
+  window_mru_view_cycle(view_.get(), 0);
+  ASSERT_EQ(CursorXid(), 1u);
+
+  Sync({});
+
+  EXPECT_EQ(view_->cursor, -1);
+}
+
+TEST_F(WindowMruListTest, CycleOnEmptyListReturnsZero) {
+  EXPECT_EQ(window_mru_view_cycle(view_.get(), 1), 0u);
+  EXPECT_EQ(view_->cursor, -1);
+}
+
+TEST_F(WindowMruListTest, CycleStartsAtMostRecentlyUsed) {
+  Touch({1, 2, 3, 4, 5});  // 5, 4, 3, 2, 1
+
+  EXPECT_EQ(window_mru_view_cycle(view_.get(), 0), 5u);
+  EXPECT_EQ(window_mru_view_cycle(view_.get(), 1), 4u);
+  EXPECT_EQ(window_mru_view_cycle(view_.get(), 2), 2u);
+  EXPECT_EQ(window_mru_view_cycle(view_.get(), -1), 3u);
+}
+
+TEST_F(WindowMruListTest, CycleWrapsAround) {
+  Touch({1, 2, 3, 4, 5});  // 5, 4, 3, 2, 1
+
+  EXPECT_EQ(window_mru_view_cycle(view_.get(), -1), 1u);
+  EXPECT_EQ(window_mru_view_cycle(view_.get(), 1), 5u);
+  // Four steps forward from the head is one step back.
+  EXPECT_EQ(window_mru_view_cycle(view_.get(), 4), 1u);
+}
+
+TEST_F(WindowMruListTest, CycleStepIsTakenModuloCount) {
+  Touch({1, 2, 3, 4, 5});  // 5, 4, 3, 2, 1
+
+  EXPECT_EQ(window_mru_view_cycle(view_.get(), 5 * 1000 + 2), 3u);
+  EXPECT_EQ(window_mru_view_cycle(view_.get(), -(5 * 1000 + 2)), 5u);
+  EXPECT_EQ(window_mru_view_cycle(view_.get(), INT32_MAX), 3u);
+  window_mru_view_clear_cursor(view_.get());
+  EXPECT_EQ(window_mru_view_cycle(view_.get(), INT32_MIN), 3u);
+}
+
+// Cycling with a huge step on a full list must still take the short way;
+// this would walk billions of links otherwise.
+TEST_F(WindowMruListTest, CycleTakesShortestWay) {
+  for (uint64_t xid = 1; xid <= WINDOW_MRU_CAPACITY; xid++) {
+    window_mru_list_touch(&list_, xid);
+  }
+
+  // INT32_MAX is one short of a multiple of the capacity: one step back
+  // from the head wraps to the tail.
+  EXPECT_EQ(window_mru_view_cycle(view_.get(), INT32_MAX), 1u);
+  window_mru_view_clear_cursor(view_.get());
+  EXPECT_EQ(window_mru_view_cycle(view_.get(), WINDOW_MRU_CAPACITY / 2),
+            static_cast<uint64_t>(WINDOW_MRU_CAPACITY / 2));
+}
+
+TEST_F(WindowMruListTest, ClearCursorReturnsSelection) {
+  Touch({1, 2, 3});
+  window_mru_view_cycle(view_.get(), 1);
+
+  EXPECT_EQ(window_mru_view_clear_cursor(view_.get()), 2u);
+  EXPECT_EQ(view_->cursor, -1);
+  EXPECT_EQ(window_mru_view_clear_cursor(view_.get()), 0u);
+  // A new cycle starts from the head again.
+  EXPECT_EQ(window_mru_view_cycle(view_.get(), 1), 2u);
+}
+
+}  // namespace
@@ -0,0 +1,234 @@
+// Checks WindowOps against a real display server. ctest runs it once under
+// Xvfb and once under a headless Weston, with WINDOW_OPS_TEST_BACKEND naming
+// the backend that should be picked.
+
+#include "window_ops.h"
+
+#include <gtest/gtest.h>
+#include <gtk/gtk.h>
+#ifdef HAVE_XTEST
+#include <X11/extensions/XTest.h>
+#include <gdk/gdkx.h>
+#endif
+
+#include <cstdio>
+#include <vector>
+
+#include "test_util.h"
+
+namespace {
+
+using test_util::ReportLatencies;
+using test_util::Spin;
+using test_util::SpinUntil;
+
+constexpr int kWaitMs = 2000;
+constexpr int kLatencySamples = 100;
+
+class WindowOpsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    window_ = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+    gtk_window_set_default_size(window_, 320, 240);
+    gtk_widget_show(GTK_WIDGET(window_));
+    ops_ = window_ops_new(window_, nullptr);
+    g_signal_connect(ops_, "geometry-changed", G_CALLBACK(geometry_changed_cb),
+                     this);
+    g_signal_connect_after(window_, "configure-event",
+                           G_CALLBACK(configure_cb), this);
+    g_signal_connect(window_, "button-press-event", G_CALLBACK(press_cb),
+                     this);
+    GdkFrameClock* frame_clock =
+        gtk_widget_get_frame_clock(GTK_WIDGET(window_));
+    g_signal_connect(frame_clock, "after-paint", G_CALLBACK(after_paint_cb),
+                     this);
+
+    // Let the window map and settle before measuring anything.
+    ASSERT_TRUE(SpinUntil([&] { return geometry_changes_ > 0; }, kWaitMs));
+    Spin(100);
+    ResetCounts();
+  }
+
+  void TearDown() override {
+    GdkFrameClock* frame_clock =
+        gtk_widget_get_frame_clock(GTK_WIDGET(window_));
+    if (frame_clock != nullptr) {
+      g_signal_handlers_disconnect_by_data(frame_clock, this);
+    }
+    g_clear_object(&ops_);
+    gtk_widget_destroy(GTK_WIDGET(window_));
+  }
+
+  void ResetCounts() {
+    geometry_changes_ = 0;
+    configures_ = 0;
+    frames_ = 0;
+  }
+
+  gint64 GeometryWidth() {
+    g_autoptr(FlValue) geometry = window_ops_get_geometry(ops_);
+    return fl_value_get_int(fl_value_lookup_string(geometry, "width"));
+  }
+
+  static void geometry_changed_cb(WindowOps* ops, gpointer user_data) {
+    WindowOpsTest* self = static_cast<WindowOpsTest*>(user_data);
+    self->geometry_changes_++;
+    self->last_change_time_ = g_get_monotonic_time();
+  }
+
+  static gboolean configure_cb(GtkWidget* widget, GdkEventConfigure* event,
+                               gpointer user_data) {
+    static_cast<WindowOpsTest*>(user_data)->configures_++;
+    return FALSE;
+  }
+
+  static gboolean press_cb(GtkWidget* widget, GdkEventButton* event,
+                           gpointer user_data) {
+    static_cast<WindowOpsTest*>(user_data)->presses_++;
+    return FALSE;
+  }
+
+  // Counts frames; paced backends post at most one update from each.
+  static void after_paint_cb(GdkFrameClock* frame_clock, gpointer user_data) {
+    static_cast<WindowOpsTest*>(user_data)->frames_++;
+  }
+
+  GtkWindow* window_ = nullptr;
+  WindowOps* ops_ = nullptr;
+  int geometry_changes_ = 0;
+  int configures_ = 0;
+  int frames_ = 0;
+  int presses_ = 0;
+  gint64 last_change_time_ = 0;
+};
+
+const gchar* ExpectedBackend() {
+  const gchar* backend = g_getenv("WINDOW_OPS_TEST_BACKEND");
+  return backend != nullptr ? backend : "gdk";
+}
+
+bool IsPaced() {
+  return g_strcmp0(ExpectedBackend(), "x11") != 0;
+}
+
+TEST_F(WindowOpsTest, PicksBackendForDisplay) {
+  EXPECT_STREQ(window_ops_get_backend_name(ops_), ExpectedBackend());
+
+  g_autoptr(FlValue) geometry = window_ops_get_geometry(ops_);
+  EXPECT_STREQ(
+      fl_value_get_string(fl_value_lookup_string(geometry, "backend")),
+      ExpectedBackend());
+  // Only X11 reveals where the window is.
+  FlValueType position_type =
+      fl_value_get_type(fl_value_lookup_string(geometry, "x"));
+  EXPECT_EQ(position_type, IsPaced() ? FL_VALUE_TYPE_NULL : FL_VALUE_TYPE_INT);
+}
+
+TEST_F(WindowOpsTest, BeginWithoutPressFails) {
+  g_autoptr(GError) move_error = nullptr;
+  EXPECT_FALSE(window_ops_begin_move(ops_, &move_error));
+  EXPECT_TRUE(g_error_matches(move_error, WINDOW_OPS_ERROR,
+                              WINDOW_OPS_ERROR_NO_PRESS));
+
+  g_autoptr(GError) resize_error = nullptr;
+  EXPECT_FALSE(
+      window_ops_begin_resize(ops_, GDK_WINDOW_EDGE_EAST, &resize_error));
+  EXPECT_TRUE(g_error_matches(resize_error, WINDOW_OPS_ERROR,
+                              WINDOW_OPS_ERROR_NO_PRESS));
+}
+
+#ifdef HAVE_XTEST
+// Hands a real press over to an interactive move. Xvfb runs no window
+// manager, so GDK moves the window itself, which it can only do once the
+// press's grab has been released through the device.
+TEST_F(WindowOpsTest, MoveFollowsPointerAfterPress) {
+  if (g_strcmp0(ExpectedBackend(), "x11") != 0) {
+    GTEST_SKIP() << "Pointer injection needs XTest";
+  }
+  Display* xdisplay =
+      gdk_x11_display_get_xdisplay(gtk_widget_get_display(GTK_WIDGET(window_)));
+  GdkWindow* gdk_window = gtk_widget_get_window(GTK_WIDGET(window_));
+  gint x = 0;
+  gint y = 0;
+  gdk_window_get_origin(gdk_window, &x, &y);
+  gint pointer_x = x + 160;
+  gint pointer_y = y + 120;
+
+  XTestFakeMotionEvent(xdisplay, -1, pointer_x, pointer_y, CurrentTime);
+  XTestFakeButtonEvent(xdisplay, 1, True, CurrentTime);
+  XFlush(xdisplay);
+  ASSERT_TRUE(SpinUntil([&] { return presses_ > 0; }, kWaitMs));
+
+  g_autoptr(GError) error = nullptr;
+  ASSERT_TRUE(window_ops_begin_move(ops_, &error)) << error->message;
+  XTestFakeMotionEvent(xdisplay, -1, pointer_x + 60, pointer_y + 40,
+                       CurrentTime);
+  XFlush(xdisplay);
+  bool moved = SpinUntil(
+      [&] {
+        gint new_x = 0;
+        gint new_y = 0;
+        gdk_window_get_origin(gdk_window, &new_x, &new_y);
+        return new_x == x + 60 && new_y == y + 40;
+      },
+      kWaitMs);
+
+  XTestFakeButtonEvent(xdisplay, 1, False, CurrentTime);
+  XFlush(xdisplay);
+  Spin(50);
+  EXPECT_TRUE(moved);
+}
+#endif
+
+TEST_F(WindowOpsTest, GeometryFollowsResize) {
+  gtk_window_resize(window_, 400, 300);
+
+  ASSERT_TRUE(SpinUntil([&] { return GeometryWidth() >= 400; }, kWaitMs));
+  EXPECT_TRUE(SpinUntil([&] { return geometry_changes_ > 0; }, kWaitMs));
+}
+
+// A burst of resizes produces at most one update per frame on paced
+// backends, and one per configure otherwise.
+TEST_F(WindowOpsTest, GeometryUpdatesArePaced) {
+  for (int i = 0; i < 50; i++) {
+    gtk_window_resize(window_, 300 + i * 4, 240);
+    g_main_context_iteration(nullptr, FALSE);
+  }
+  ASSERT_TRUE(SpinUntil([&] { return GeometryWidth() >= 496; }, kWaitMs));
+  Spin(200);
+
+  ASSERT_GT(geometry_changes_, 0);
+  if (IsPaced()) {
+    EXPECT_LE(geometry_changes_, frames_);
+    EXPECT_LE(geometry_changes_, configures_);
+  } else {
+    EXPECT_EQ(geometry_changes_, configures_);
+  }
+  printf("%s: %d configures, %d frames, %d geometry updates\n",
+         ExpectedBackend(), configures_, frames_, geometry_changes_);
+}
+
+// Reports the time from requesting a new size to Dart being told about it.
+TEST_F(WindowOpsTest, ResizeToGeometryLatency) {
+  std::vector<gint64> latencies;
+  for (int i = 0; i < kLatencySamples; i++) {
+    ResetCounts();
+    gint64 start = g_get_monotonic_time();
+    gtk_window_resize(window_, i % 2 == 0 ? 480 : 360, 240);
+    ASSERT_TRUE(SpinUntil([&] { return geometry_changes_ > 0; }, kWaitMs))
+        << "sample " << i;
+    latencies.push_back(last_change_time_ - start);
+    // Let trailing configures of this sample drain.
+    Spin(20);
+  }
+
+  g_autofree gchar* label = g_strdup_printf(
+      "%s resize-to-geometry latency", ExpectedBackend());
+  ReportLatencies(label, &latencies);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  return test_util::RunDisplayTests(argc, argv);
+}
@@ -0,0 +1,53 @@
+#include "window_core/gtk_backend.h"
+
+namespace window_core {
+
+Rect GtkBackend::GetFrame() const {
+  GdkWindow* gdk_window = gtk_widget_get_window(GTK_WIDGET(window_));
+  if (gdk_window == nullptr) {
+    Rect frame = {};
+    gtk_window_get_position(window_, &frame.x, &frame.y);
+    gtk_window_get_size(window_, &frame.width, &frame.height);
+    return frame;
+  }
+  GdkRectangle extents;
+  gdk_window_get_frame_extents(gdk_window, &extents);
+  return {extents.x, extents.y, extents.width, extents.height};
+}
+
+Rect GtkBackend::GetWorkArea() const {
+  GdkWindow* gdk_window = gtk_widget_get_window(GTK_WIDGET(window_));
+  if (gdk_window == nullptr) {
+    return GetFrame();
+  }
+  GdkMonitor* monitor = gdk_display_get_monitor_at_window(
+      gdk_window_get_display(gdk_window), gdk_window);
+  GdkRectangle work_area;
+  gdk_monitor_get_workarea(monitor, &work_area);
+  return {work_area.x, work_area.y, work_area.width, work_area.height};
+}
+
+void GtkBackend::Move(int x, int y) {
+  // With the default NorthWest gravity this positions the frame's origin.
+  gtk_window_move(window_, x, y);
+}
+
+void GtkBackend::SetFrame(const Rect& frame) {
+  if (gtk_window_is_maximized(window_)) {
+    gtk_window_unmaximize(window_);
+  }
+  // gtk_window_resize() takes the client size, so remove the decorations.
+  Rect current = GetFrame();
+  int width = 0;
+  int height = 0;
+  gtk_window_get_size(window_, &width, &height);
+  gtk_window_move(window_, frame.x, frame.y);
+  gtk_window_resize(window_, MAX(1, frame.width - (current.width - width)),
+                    MAX(1, frame.height - (current.height - height)));
+}
+
+void GtkBackend::Maximize() {
+  gtk_window_maximize(window_);
+}
+
+}  // namespace window_core
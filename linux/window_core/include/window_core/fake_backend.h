@@ -0,0 +1,50 @@
+#ifndef WINDOW_CORE_FAKE_BACKEND_H_
+#define WINDOW_CORE_FAKE_BACKEND_H_
+
+#include "window_core/window_core.h"
+
+namespace window_core {
+
+// An in-memory WindowCore backend with no display, for deterministic unit
+// tests and micro-benchmarks. Every request is applied immediately, the
+// way a window manager that honours all requests would.
+class FakeBackend {
+ public:
+  FakeBackend(const Rect& frame, const Rect& work_area)
+      : frame_(frame), work_area_(work_area) {}
+
+  Rect GetFrame() const { return frame_; }
+  Rect GetWorkArea() const { return work_area_; }
+
+  void Move(int x, int y) {
+    frame_.x = x;
+    frame_.y = y;
+    maximized_ = false;
+    move_count_++;
+  }
+
+  void SetFrame(const Rect& frame) {
+    frame_ = frame;
+    maximized_ = false;
+  }
+
+  void Maximize() {
+    frame_ = work_area_;
+    maximized_ = true;
+  }
+
+  bool maximized() const { return maximized_; }
+
+  // Number of Move() calls, i.e. requests a real backend would send.
+  int move_count() const { return move_count_; }
+
+ private:
+  Rect frame_;
+  Rect work_area_;
+  bool maximized_ = false;
+  int move_count_ = 0;
+};
+
+}  // namespace window_core
+
+#endif  // WINDOW_CORE_FAKE_BACKEND_H_
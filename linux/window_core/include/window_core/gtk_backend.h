@@ -0,0 +1,30 @@
+#ifndef WINDOW_CORE_GTK_BACKEND_H_
+#define WINDOW_CORE_GTK_BACKEND_H_
+
+#include <gtk/gtk.h>
+
+#include "window_core/window_core.h"
+
+namespace window_core {
+
+// WindowCore backend for a GtkWindow. Moves are positioning requests to the
+// window manager, so it is only effective on X11; Wayland compositors
+// ignore client-side positioning.
+class GtkBackend {
+ public:
+  // |window| must outlive the backend.
+  explicit GtkBackend(GtkWindow* window) : window_(window) {}
+
+  Rect GetFrame() const;
+  Rect GetWorkArea() const;
+  void Move(int x, int y);
+  void SetFrame(const Rect& frame);
+  void Maximize();
+
+ private:
+  GtkWindow* window_;
+};
+
+}  // namespace window_core
+
+#endif  // WINDOW_CORE_GTK_BACKEND_H_
@@ -0,0 +1,170 @@
+#ifndef WINDOW_CORE_WINDOW_CORE_H_
+#define WINDOW_CORE_WINDOW_CORE_H_
+
+#include <cstdlib>
+
+namespace window_core {
+
+// A rectangle in logical pixels, in root window coordinates.
+struct Rect {
+  int x;
+  int y;
+  int width;
+  int height;
+};
+
+// Layout applied when a drag ends with the pointer at a work area edge.
+enum class SnapZone {
+  kNone,
+  kLeftHalf,
+  kRightHalf,
+  kMaximize,
+};
+
+// Snapping tolerances in logical pixels.
+struct SnapConfig {
+  // Window edges closer than this to a work area edge stick to it.
+  int edge_threshold = 16;
+  // Pointer positions closer than this to the left, right or top edge of
+  // the work area arm the matching SnapZone.
+  int zone_threshold = 4;
+};
+
+// Returns |start| moved so that the span [start, start + length) touches
+// the nearest edge of [area_start, area_start + area_length) within
+// |threshold|, or |start| unchanged if no edge is close enough.
+inline int SnapSpan(int start, int length, int area_start, int area_length,
+                    int threshold) {
+  int to_start = area_start - start;
+  int to_end = (area_start + area_length) - (start + length);
+  if (std::abs(to_start) <= threshold &&
+      std::abs(to_start) <= std::abs(to_end)) {
+    return area_start;
+  }
+  if (std::abs(to_end) <= threshold) {
+    return start + to_end;
+  }
+  return start;
+}
+
+// Returns the SnapZone armed by a pointer at (x, y).
+inline SnapZone ZoneForPointer(int x, int y, const Rect& work_area,
+                               int threshold) {
+  if (y - work_area.y < threshold) {
+    return SnapZone::kMaximize;
+  }
+  if (x - work_area.x < threshold) {
+    return SnapZone::kLeftHalf;
+  }
+  if ((work_area.x + work_area.width) - x <= threshold) {
+    return SnapZone::kRightHalf;
+  }
+  return SnapZone::kNone;
+}
+
+// Returns the frame a window takes when dropped in |zone|.
+inline Rect ZoneRect(SnapZone zone, const Rect& work_area) {
+  int half = work_area.width / 2;
+  switch (zone) {
+    case SnapZone::kLeftHalf:
+      return {work_area.x, work_area.y, half, work_area.height};
+    case SnapZone::kRightHalf:
+      return {work_area.x + half, work_area.y, work_area.width - half,
+              work_area.height};
+    case SnapZone::kNone:
+    case SnapZone::kMaximize:
+      break;
+  }
+  return work_area;
+}
+
+// Portable window logic: drag tracking with edge snapping and drop zones.
+//
+// |Backend| is a policy supplying the windowing system, so calls on the
+// drag hot path are resolved at compile time. It must provide:
+//
+//   Rect GetFrame();              // Outer frame, decorations included.
+//   Rect GetWorkArea();           // Work area of the window's monitor.
+//   void Move(int x, int y);      // Moves the outer frame's origin.
+//   void SetFrame(const Rect&);   // Moves and resizes the outer frame.
+//   void Maximize();
+//
+// See GtkBackend for the runner and FakeBackend for tests and benchmarks.
+template <typename Backend>
+class WindowCore {
+ public:
+  explicit WindowCore(Backend backend, SnapConfig config = SnapConfig())
+      : backend_(backend), config_(config) {}
+
+  Backend& backend() { return backend_; }
+  const Backend& backend() const { return backend_; }
+
+  bool dragging() const { return dragging_; }
+
+  // The zone the current drag would drop into.
+  SnapZone zone() const { return zone_; }
+
+  // Starts dragging with the pointer at (pointer_x, pointer_y). The frame
+  // and work area are sampled once here so updates need no queries.
+  void BeginDrag(int pointer_x, int pointer_y) {
+    frame_ = backend_.GetFrame();
+    work_area_ = backend_.GetWorkArea();
+    grab_x_ = pointer_x - frame_.x;
+    grab_y_ = pointer_y - frame_.y;
+    zone_ = SnapZone::kNone;
+    dragging_ = true;
+  }
+
+  // Follows the pointer, snapping the frame to nearby work area edges.
+  // Returns the zone the window would drop into if released now.
+  SnapZone UpdateDrag(int pointer_x, int pointer_y) {
+    if (!dragging_) {
+      return SnapZone::kNone;
+    }
+    int x = SnapSpan(pointer_x - grab_x_, frame_.width, work_area_.x,
+                     work_area_.width, config_.edge_threshold);
+    int y = SnapSpan(pointer_y - grab_y_, frame_.height, work_area_.y,
+                     work_area_.height, config_.edge_threshold);
+    if (x != frame_.x || y != frame_.y) {
+      frame_.x = x;
+      frame_.y = y;
+      backend_.Move(x, y);
+    }
+    zone_ = ZoneForPointer(pointer_x, pointer_y, work_area_,
+                           config_.zone_threshold);
+    return zone_;
+  }
+
+  // Finishes the drag, applying the armed zone's layout if any.
+  SnapZone EndDrag() {
+    if (!dragging_) {
+      return SnapZone::kNone;
+    }
+    dragging_ = false;
+    if (zone_ == SnapZone::kMaximize) {
+      backend_.Maximize();
+    } else if (zone_ != SnapZone::kNone) {
+      backend_.SetFrame(ZoneRect(zone_, work_area_));
+    }
+    return zone_;
+  }
+
+ private:
+  Backend backend_;
+  SnapConfig config_;
+
+  bool dragging_ = false;
+  SnapZone zone_ = SnapZone::kNone;
+
+  // Frame as last moved, and the work area sampled at BeginDrag().
+  Rect frame_ = {};
+  Rect work_area_ = {};
+
+  // Pointer offset from the frame origin when the drag started.
+  int grab_x_ = 0;
+  int grab_y_ = 0;
+};
+
+}  // namespace window_core
+
+#endif  // WINDOW_CORE_WINDOW_CORE_H_
@@ -0,0 +1,91 @@
+// Costs of the snap drag hot path, measured against FakeBackend so only the
+// core's own work is timed.
+
+#include <benchmark/benchmark.h>
+
+#include "window_core/fake_backend.h"
+#include "window_core/window_core.h"
+
+namespace window_core {
+namespace {
+
+constexpr Rect kWorkArea = {0, 32, 1920, 1048};
+constexpr Rect kFrame = {100, 200, 800, 600};
+
+// Pointer positions sweeping across the work area and its edges, so that
+// snapping and zone changes are exercised as in a real drag.
+constexpr int kPathLength = 1024;
+
+struct Point {
+  int x;
+  int y;
+};
+
+const Point* PointerPath() {
+  static Point path[kPathLength];
+  static bool initialized = false;
+  if (!initialized) {
+    for (int i = 0; i < kPathLength; i++) {
+      path[i] = {(i * 7) % (kWorkArea.width + 40) - 20,
+                 kWorkArea.y + (i * 13) % kWorkArea.height};
+    }
+    initialized = true;
+  }
+  return path;
+}
+
+void BM_SnapSpan(benchmark::State& state) {
+  const Point* path = PointerPath();
+  int i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        SnapSpan(path[i].x, kFrame.width, kWorkArea.x, kWorkArea.width, 16));
+    i = (i + 1) % kPathLength;
+  }
+}
+BENCHMARK(BM_SnapSpan);
+
+void BM_ZoneForPointer(benchmark::State& state) {
+  const Point* path = PointerPath();
+  int i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ZoneForPointer(path[i].x, path[i].y, kWorkArea, 4));
+    i = (i + 1) % kPathLength;
+  }
+}
+BENCHMARK(BM_ZoneForPointer);
+
+// One pointer motion event during a snap drag.
+void BM_UpdateDrag(benchmark::State& state) {
+  const Point* path = PointerPath();
+  WindowCore<FakeBackend> core(FakeBackend(kFrame, kWorkArea));
+  core.BeginDrag(kFrame.x + 50, kFrame.y + 10);
+  int i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(core.UpdateDrag(path[i].x, path[i].y));
+    i = (i + 1) % kPathLength;
+  }
+  state.counters["moves_per_update"] = benchmark::Counter(
+      core.backend().move_count(), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_UpdateDrag);
+
+// A whole drag: press, a path of motion events, release.
+void BM_DragSequence(benchmark::State& state) {
+  const Point* path = PointerPath();
+  int length = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    WindowCore<FakeBackend> core(FakeBackend(kFrame, kWorkArea));
+    core.BeginDrag(kFrame.x + 50, kFrame.y + 10);
+    for (int i = 0; i < length; i++) {
+      benchmark::DoNotOptimize(core.UpdateDrag(path[i].x, path[i].y));
+    }
+    benchmark::DoNotOptimize(core.EndDrag());
+  }
+  state.SetItemsProcessed(state.iterations() * length);
+}
+BENCHMARK(BM_DragSequence)->Arg(64)->Arg(kPathLength);
+
+}  // namespace
+}  // namespace window_core
@@ -0,0 +1,203 @@
+#include "window_core/window_core.h"
+
+#include <gtest/gtest.h>
+
+#include "window_core/fake_backend.h"
+
+namespace window_core {
+
+// Declared in the namespace of Rect so that gtest finds them.
+inline bool operator==(const Rect& a, const Rect& b) {
+  return a.x == b.x && a.y == b.y && a.width == b.width &&
+         a.height == b.height;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const Rect& rect) {
+  return os << "{" << rect.x << ", " << rect.y << ", " << rect.width << ", "
+            << rect.height << "}";
+}
+
+namespace {
+
+// A 1920x1080 monitor with a 32 pixel top panel.
+constexpr Rect kWorkArea = {0, 32, 1920, 1048};
+constexpr Rect kFrame = {100, 200, 800, 600};
+
+TEST(SnapSpanTest, LeavesDistantSpanAlone) {
+  EXPECT_EQ(SnapSpan(100, 800, 0, 1920, 16), 100);
+}
+
+TEST(SnapSpanTest, SnapsToAreaStartWithinThreshold) {
+  EXPECT_EQ(SnapSpan(16, 800, 0, 1920, 16), 0);
+  EXPECT_EQ(SnapSpan(-16, 800, 0, 1920, 16), 0);
+  EXPECT_EQ(SnapSpan(17, 800, 0, 1920, 16), 17);
+}
+
+TEST(SnapSpanTest, SnapsToAreaEndWithinThreshold) {
+  // The span ends at 1910, 10 pixels short of the area end.
+  EXPECT_EQ(SnapSpan(1110, 800, 0, 1920, 16), 1120);
+  // The span overhangs the end by 16 pixels.
+  EXPECT_EQ(SnapSpan(1136, 800, 0, 1920, 16), 1120);
+  EXPECT_EQ(SnapSpan(1137, 800, 0, 1920, 16), 1137);
+}
+
+TEST(SnapSpanTest, PrefersNearerEdgeWhenBothAreClose) {
+  // A 1910 pixel span in a 1920 pixel area is near both edges.
+  EXPECT_EQ(SnapSpan(3, 1910, 0, 1920, 16), 0);
+  EXPECT_EQ(SnapSpan(8, 1910, 0, 1920, 16), 10);
+}
+
+TEST(SnapSpanTest, HonoursAreaOffset) {
+  EXPECT_EQ(SnapSpan(40, 600, 32, 1048, 16), 32);
+  EXPECT_EQ(SnapSpan(470, 600, 32, 1048, 16), 480);
+}
+
+TEST(ZoneForPointerTest, TopEdgeMaximizes) {
+  EXPECT_EQ(ZoneForPointer(960, 32, kWorkArea, 4), SnapZone::kMaximize);
+  EXPECT_EQ(ZoneForPointer(960, 35, kWorkArea, 4), SnapZone::kMaximize);
+  EXPECT_EQ(ZoneForPointer(960, 36, kWorkArea, 4), SnapZone::kNone);
+}
+
+TEST(ZoneForPointerTest, TopEdgeWinsInCorners) {
+  EXPECT_EQ(ZoneForPointer(0, 32, kWorkArea, 4), SnapZone::kMaximize);
+  EXPECT_EQ(ZoneForPointer(1919, 32, kWorkArea, 4), SnapZone::kMaximize);
+}
+
+TEST(ZoneForPointerTest, SideEdgesArmHalves) {
+  EXPECT_EQ(ZoneForPointer(0, 500, kWorkArea, 4), SnapZone::kLeftHalf);
+  EXPECT_EQ(ZoneForPointer(3, 500, kWorkArea, 4), SnapZone::kLeftHalf);
+  EXPECT_EQ(ZoneForPointer(4, 500, kWorkArea, 4), SnapZone::kNone);
+  // The last pixel column is 1 pixel from the right edge.
+  EXPECT_EQ(ZoneForPointer(1919, 500, kWorkArea, 4), SnapZone::kRightHalf);
+  EXPECT_EQ(ZoneForPointer(1916, 500, kWorkArea, 4), SnapZone::kRightHalf);
+  EXPECT_EQ(ZoneForPointer(1915, 500, kWorkArea, 4), SnapZone::kNone);
+}
+
+TEST(ZoneForPointerTest, MiddleArmsNothing) {
+  EXPECT_EQ(ZoneForPointer(960, 540, kWorkArea, 4), SnapZone::kNone);
+}
+
+TEST(ZoneRectTest, HalvesSplitWorkArea) {
+  EXPECT_EQ(ZoneRect(SnapZone::kLeftHalf, kWorkArea),
+            (Rect{0, 32, 960, 1048}));
+  EXPECT_EQ(ZoneRect(SnapZone::kRightHalf, kWorkArea),
+            (Rect{960, 32, 960, 1048}));
+}
+
+TEST(ZoneRectTest, RightHalfTakesOddPixel) {
+  const Rect odd = {10, 0, 1001, 700};
+  EXPECT_EQ(ZoneRect(SnapZone::kLeftHalf, odd), (Rect{10, 0, 500, 700}));
+  EXPECT_EQ(ZoneRect(SnapZone::kRightHalf, odd), (Rect{510, 0, 501, 700}));
+}
+
+TEST(ZoneRectTest, MaximizeAndNoneCoverWorkArea) {
+  EXPECT_EQ(ZoneRect(SnapZone::kMaximize, kWorkArea), kWorkArea);
+  EXPECT_EQ(ZoneRect(SnapZone::kNone, kWorkArea), kWorkArea);
+}
+
+class WindowCoreTest : public ::testing::Test {
+ protected:
+  WindowCore<FakeBackend> core_{FakeBackend(kFrame, kWorkArea)};
+
+  const FakeBackend& backend() const { return core_.backend(); }
+};
+
+TEST_F(WindowCoreTest, UpdateWithoutDragDoesNothing) {
+  EXPECT_FALSE(core_.dragging());
+  EXPECT_EQ(core_.UpdateDrag(0, 0), SnapZone::kNone);
+  EXPECT_EQ(core_.EndDrag(), SnapZone::kNone);
+  EXPECT_EQ(backend().move_count(), 0);
+  EXPECT_EQ(backend().GetFrame(), kFrame);
+}
+
+TEST_F(WindowCoreTest, DragFollowsPointerFromGrabOffset) {
+  core_.BeginDrag(150, 210);
+  EXPECT_TRUE(core_.dragging());
+
+  EXPECT_EQ(core_.UpdateDrag(450, 510), SnapZone::kNone);
+  EXPECT_EQ(backend().GetFrame(), (Rect{400, 500, 800, 600}));
+  EXPECT_EQ(backend().move_count(), 1);
+}
+
+TEST_F(WindowCoreTest, UnchangedPositionSendsNoMove) {
+  core_.BeginDrag(150, 210);
+  core_.UpdateDrag(150, 210);
+  EXPECT_EQ(backend().move_count(), 0);
+
+  core_.UpdateDrag(160, 210);
+  core_.UpdateDrag(160, 210);
+  EXPECT_EQ(backend().move_count(), 1);
+}
+
+TEST_F(WindowCoreTest, DragSnapsFrameToWorkAreaEdges) {
+  core_.BeginDrag(150, 210);
+
+  // The frame would land at (10, 42), within 16 pixels of the left and top
+  // work area edges.
+  core_.UpdateDrag(60, 52);
+  EXPECT_EQ(backend().GetFrame(), (Rect{0, 32, 800, 600}));
+
+  // 10 pixels short of the right edge.
+  core_.UpdateDrag(1160, 500);
+  EXPECT_EQ(backend().GetFrame().x, 1120);
+}
+
+TEST_F(WindowCoreTest, ReleaseInLeftZoneAppliesLeftHalf) {
+  core_.BeginDrag(150, 210);
+  EXPECT_EQ(core_.UpdateDrag(2, 500), SnapZone::kLeftHalf);
+  EXPECT_EQ(core_.zone(), SnapZone::kLeftHalf);
+
+  EXPECT_EQ(core_.EndDrag(), SnapZone::kLeftHalf);
+  EXPECT_FALSE(core_.dragging());
+  EXPECT_EQ(backend().GetFrame(), (Rect{0, 32, 960, 1048}));
+  EXPECT_FALSE(backend().maximized());
+}
+
+TEST_F(WindowCoreTest, ReleaseInRightZoneAppliesRightHalf) {
+  core_.BeginDrag(150, 210);
+  core_.UpdateDrag(1918, 500);
+
+  EXPECT_EQ(core_.EndDrag(), SnapZone::kRightHalf);
+  EXPECT_EQ(backend().GetFrame(), (Rect{960, 32, 960, 1048}));
+}
+
+TEST_F(WindowCoreTest, ReleaseAtTopMaximizes) {
+  core_.BeginDrag(150, 210);
+  core_.UpdateDrag(960, 33);
+
+  EXPECT_EQ(core_.EndDrag(), SnapZone::kMaximize);
+  EXPECT_TRUE(backend().maximized());
+  EXPECT_EQ(backend().GetFrame(), kWorkArea);
+}
+
+TEST_F(WindowCoreTest, LeavingZoneDisarmsIt) {
+  core_.BeginDrag(150, 210);
+  core_.UpdateDrag(2, 300);
+  core_.UpdateDrag(600, 300);
+
+  EXPECT_EQ(core_.EndDrag(), SnapZone::kNone);
+  EXPECT_EQ(backend().GetFrame(), (Rect{550, 290, 800, 600}));
+  EXPECT_FALSE(backend().maximized());
+}
+
+TEST_F(WindowCoreTest, EndDragTwiceAppliesOnce) {
+  core_.BeginDrag(150, 210);
+  core_.UpdateDrag(960, 33);
+  EXPECT_EQ(core_.EndDrag(), SnapZone::kMaximize);
+  EXPECT_EQ(core_.EndDrag(), SnapZone::kNone);
+}
+
+TEST_F(WindowCoreTest, CustomThresholds) {
+  SnapConfig config;
+  config.edge_threshold = 0;
+  config.zone_threshold = 0;
+  WindowCore<FakeBackend> core(FakeBackend(kFrame, kWorkArea), config);
+
+  core.BeginDrag(150, 210);
+  EXPECT_EQ(core.UpdateDrag(51, 500), SnapZone::kNone);
+  EXPECT_EQ(core.backend().GetFrame().x, 1);
+  EXPECT_EQ(core.UpdateDrag(0, 500), SnapZone::kNone);
+}
+
+}  // namespace
+}  // namespace window_core
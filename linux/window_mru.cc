@@ -0,0 +1,383 @@
+#include "window_mru.h"
+
+#include <gdk/gdkx.h>
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+
+#include <cstring>
+
+namespace {
+
+constexpr char kChannelName[] = "function_window_drag/mru";
+
+// Upper bound on the number of ids read from a window list property.
+constexpr long kMaxListedWindows = WINDOW_MRU_CAPACITY * 4;
+
+}  // namespace
+
+struct _WindowMru {
+  GObject parent_instance;
+
+  // Application window (weak reference).
+  GtkWindow* window;
+
+  FlMethodChannel* channel;
+
+  // X11 connection, or nullptr when not running on X11.
+  Display* xdisplay;
+  Window root;
+  Atom net_active_window;
+  Atom net_client_list;
+  Atom net_client_list_stacking;
+
+  // Maintains the static view, which outlives every list because Dart may
+  // still hold its address. |list.view| is cleared under view_lock on
+  // dispose.
+  WindowMruList list;
+};
+
+G_DEFINE_TYPE(WindowMru, window_mru, G_TYPE_OBJECT)
+
+// The list exposed through FFI, as Dart has no handle to pass in. Only
+// read or written with view_lock held, so an FFI call from the Dart UI
+// thread never sees a list that is being disposed.
+static WindowMru* ffi_mru = nullptr;
+
+// Serializes writers of the view, and guards ffi_mru and WindowMru::list.view.
+// The FFI cycle entry points may be called from the Dart UI thread while
+// the list is updated, or disposed, on GTK's.
+static GMutex view_lock;
+
+// Brackets a modification of the shared view, see WindowMruView.
+static void view_write_begin(WindowMruView* view) {
+  g_mutex_lock(&view_lock);
+  g_atomic_int_inc(&view->sequence);
+}
+
+static void view_write_end(WindowMruView* view) {
+  g_atomic_int_inc(&view->sequence);
+  g_mutex_unlock(&view_lock);
+}
+
+// The view shared through FFI. Dart keeps its address, so it is never freed;
+// a disposed list leaves it empty instead.
+static WindowMruView shared_view;
+
+// Moves |xid| to the front of the list, adding it if needed.
+static void window_mru_touch(WindowMru* self, uint64_t xid) {
+  if (xid == 0 || window_mru_list_is_front(&self->list, xid)) {
+    return;
+  }
+  view_write_begin(self->list.view);
+  window_mru_list_touch(&self->list, xid);
+  view_write_end(self->list.view);
+}
+
+// Reads a list of windows stored on the root window. The result must be
+// released with XFree().
+static Window* read_window_list(WindowMru* self, Atom property,
+                                unsigned long* n_windows) {
+  Atom type = None;
+  int format = 0;
+  unsigned long bytes_after = 0;
+  unsigned char* data = nullptr;
+  *n_windows = 0;
+  if (XGetWindowProperty(self->xdisplay, self->root, property, 0,
+                         kMaxListedWindows, False, XA_WINDOW, &type, &format,
+                         n_windows, &bytes_after, &data) != Success) {
+    return nullptr;
+  }
+  if (type != XA_WINDOW || format != 32) {
+    if (data != nullptr) {
+      XFree(data);
+    }
+    *n_windows = 0;
+    return nullptr;
+  }
+  return reinterpret_cast<Window*>(data);
+}
+
+static void window_mru_update_active(WindowMru* self) {
+  unsigned long n_windows = 0;
+  Window* windows = read_window_list(self, self->net_active_window, &n_windows);
+  if (windows == nullptr) {
+    return;
+  }
+  if (n_windows > 0) {
+    window_mru_touch(self, windows[0]);
+  }
+  XFree(windows);
+}
+
+// Drops windows that are no longer managed and appends newly mapped windows
+// that have not been focused yet.
+static void window_mru_sync_client_list(WindowMru* self) {
+  unsigned long n_windows = 0;
+  Window* windows = read_window_list(self, self->net_client_list, &n_windows);
+  if (windows == nullptr) {
+    return;
+  }
+
+  view_write_begin(self->list.view);
+  window_mru_list_begin_sync(&self->list);
+  for (unsigned long i = 0; i < n_windows; i++) {
+    window_mru_list_mark(&self->list, windows[i]);
+  }
+  window_mru_list_end_sync(&self->list);
+  view_write_end(self->list.view);
+  XFree(windows);
+}
+
+// Seeds the list from the stacking order, topmost window first.
+static void window_mru_load_initial(WindowMru* self) {
+  unsigned long n_windows = 0;
+  Window* windows =
+      read_window_list(self, self->net_client_list_stacking, &n_windows);
+  if (windows != nullptr) {
+    view_write_begin(self->list.view);
+    for (unsigned long i = 0; i < n_windows; i++) {
+      window_mru_list_add(&self->list, windows[i], true);
+    }
+    view_write_end(self->list.view);
+    XFree(windows);
+  }
+  window_mru_sync_client_list(self);
+  window_mru_update_active(self);
+}
+
+static GdkFilterReturn window_mru_filter(GdkXEvent* gdk_xevent,
+                                         GdkEvent* event, gpointer user_data) {
+  WindowMru* self = WINDOW_MRU(user_data);
+  XEvent* xevent = static_cast<XEvent*>(gdk_xevent);
+  if (xevent->type != PropertyNotify ||
+      xevent->xproperty.window != self->root) {
+    return GDK_FILTER_CONTINUE;
+  }
+  if (xevent->xproperty.atom == self->net_active_window) {
+    window_mru_update_active(self);
+  } else if (xevent->xproperty.atom == self->net_client_list) {
+    window_mru_sync_client_list(self);
+  }
+  return GDK_FILTER_CONTINUE;
+}
+
+// Keeps the list usable under window managers without EWMH support.
+static gboolean focus_in_cb(GtkWidget* widget, GdkEvent* event,
+                            gpointer user_data) {
+  WindowMru* self = WINDOW_MRU(user_data);
+  GdkWindow* gdk_window = gtk_widget_get_window(widget);
+  if (gdk_window != nullptr && GDK_IS_X11_WINDOW(gdk_window)) {
+    window_mru_touch(self, gdk_x11_window_get_xid(gdk_window));
+  }
+  return FALSE;
+}
+
+static FlValue* window_mru_list_windows(WindowMru* self) {
+  FlValue* result = fl_value_new_list();
+  const WindowMruView* view = self->list.view;
+  for (int32_t slot = view->head; slot >= 0; slot = view->slots[slot].next) {
+    fl_value_append_take(result, fl_value_new_int(view->slots[slot].xid));
+  }
+  return result;
+}
+
+static void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
+                           gpointer user_data) {
+  WindowMru* self = WINDOW_MRU(user_data);
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "getWindows") == 0) {
+    g_autoptr(FlValue) result = window_mru_list_windows(self);
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  } else if (strcmp(method, "cycle") == 0) {
+    if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_INT) {
+      response = FL_METHOD_RESPONSE(fl_method_error_response_new(
+          "bad_args", "Expected an int step", nullptr));
+    } else {
+      g_autoptr(FlValue) result = fl_value_new_int(
+          window_mru_cycle(self, static_cast<int32_t>(fl_value_get_int(args))));
+      response = FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+    }
+  } else if (strcmp(method, "endCycle") == 0) {
+    gboolean activate = args != nullptr &&
+                        fl_value_get_type(args) == FL_VALUE_TYPE_BOOL &&
+                        fl_value_get_bool(args);
+    window_mru_end_cycle(self, activate);
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+  } else {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error)) {
+    g_warning("Failed to send MRU response: %s", error->message);
+  }
+}
+
+// Implements GObject::dispose.
+static void window_mru_dispose(GObject* object) {
+  WindowMru* self = WINDOW_MRU(object);
+
+  // The GTK thread is the only writer of |list.view|, so it can be tested
+  // without the lock; clearing it and |ffi_mru| takes the lock so that FFI
+  // calls in flight finish first and later ones see no list.
+  if (self->list.view != nullptr) {
+    view_write_begin(&shared_view);
+    if (ffi_mru == self) {
+      ffi_mru = nullptr;
+    }
+    window_mru_view_clear(&shared_view);
+    self->list.view = nullptr;
+    view_write_end(&shared_view);
+  }
+  if (self->xdisplay != nullptr) {
+    gdk_window_remove_filter(nullptr, window_mru_filter, self);
+    self->xdisplay = nullptr;
+  }
+  if (self->window != nullptr) {
+    g_signal_handlers_disconnect_by_data(self->window, self);
+    g_object_remove_weak_pointer(G_OBJECT(self->window),
+                                 reinterpret_cast<gpointer*>(&self->window));
+    self->window = nullptr;
+  }
+  g_clear_object(&self->channel);
+  window_mru_list_free(&self->list);
+
+  G_OBJECT_CLASS(window_mru_parent_class)->dispose(object);
+}
+
+static void window_mru_class_init(WindowMruClass* klass) {
+  G_OBJECT_CLASS(klass)->dispose = window_mru_dispose;
+}
+
+static void window_mru_init(WindowMru* self) {
+  view_write_begin(&shared_view);
+  window_mru_list_init(&self->list, &shared_view);
+  view_write_end(&shared_view);
+}
+
+WindowMru* window_mru_new(GtkWindow* window, FlBinaryMessenger* messenger) {
+  WindowMru* self = WINDOW_MRU(g_object_new(window_mru_get_type(), nullptr));
+
+  self->window = window;
+  g_object_add_weak_pointer(G_OBJECT(window),
+                            reinterpret_cast<gpointer*>(&self->window));
+  g_signal_connect(window, "focus-in-event", G_CALLBACK(focus_in_cb), self);
+
+  GdkDisplay* display = gtk_widget_get_display(GTK_WIDGET(window));
+  if (GDK_IS_X11_DISPLAY(display)) {
+    self->xdisplay = gdk_x11_display_get_xdisplay(display);
+    self->root = DefaultRootWindow(self->xdisplay);
+    self->net_active_window =
+        XInternAtom(self->xdisplay, "_NET_ACTIVE_WINDOW", False);
+    self->net_client_list =
+        XInternAtom(self->xdisplay, "_NET_CLIENT_LIST", False);
+    self->net_client_list_stacking =
+        XInternAtom(self->xdisplay, "_NET_CLIENT_LIST_STACKING", False);
+
+    // Add to, rather than replace, the events GDK already selected.
+    XWindowAttributes attributes;
+    XGetWindowAttributes(self->xdisplay, self->root, &attributes);
+    XSelectInput(self->xdisplay, self->root,
+                 attributes.your_event_mask | PropertyChangeMask);
+    gdk_window_add_filter(nullptr, window_mru_filter, self);
+    window_mru_load_initial(self);
+  }
+
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  self->channel = fl_method_channel_new(messenger, kChannelName,
+                                        FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(self->channel, method_call_cb,
+                                            self, nullptr);
+
+  g_mutex_lock(&view_lock);
+  ffi_mru = self;
+  g_mutex_unlock(&view_lock);
+  return self;
+}
+
+uint64_t window_mru_cycle(WindowMru* self, int32_t step) {
+  g_return_val_if_fail(WINDOW_IS_MRU(self), 0);
+
+  view_write_begin(&shared_view);
+  uint64_t xid = self->list.view != nullptr
+                     ? window_mru_view_cycle(self->list.view, step)
+                     : 0;
+  view_write_end(&shared_view);
+  return xid;
+}
+
+// Asks the window manager to activate |xid|. Must be called on the GTK
+// thread, which owns the X connection.
+static void window_mru_activate(WindowMru* self, uint64_t xid) {
+  if (xid == 0 || self->xdisplay == nullptr) {
+    return;
+  }
+  // Source indication 2 marks the request as coming from a pager, which
+  // window managers honour without focus-stealing prevention.
+  XEvent xevent = {};
+  xevent.xclient.type = ClientMessage;
+  xevent.xclient.window = xid;
+  xevent.xclient.message_type = self->net_active_window;
+  xevent.xclient.format = 32;
+  xevent.xclient.data.l[0] = 2;
+  xevent.xclient.data.l[1] = CurrentTime;
+  XSendEvent(self->xdisplay, self->root, False,
+             SubstructureRedirectMask | SubstructureNotifyMask, &xevent);
+  XFlush(self->xdisplay);
+}
+
+void window_mru_end_cycle(WindowMru* self, gboolean activate) {
+  g_return_if_fail(WINDOW_IS_MRU(self));
+
+  view_write_begin(&shared_view);
+  uint64_t xid = self->list.view != nullptr
+                     ? window_mru_view_clear_cursor(self->list.view)
+                     : 0;
+  view_write_end(&shared_view);
+  if (activate) {
+    window_mru_activate(self, xid);
+  }
+}
+
+const WindowMruView* window_mru_get_view() {
+  return &shared_view;
+}
+
+uint64_t window_mru_ffi_cycle(int32_t step) {
+  view_write_begin(&shared_view);
+  uint64_t xid =
+      ffi_mru != nullptr ? window_mru_view_cycle(&shared_view, step) : 0;
+  view_write_end(&shared_view);
+  return xid;
+}
+
+// Runs on the GTK thread, which is the only one that disposes lists, so
+// |ffi_mru| cannot go away while the request is sent.
+static gboolean activate_cb(gpointer user_data) {
+  g_mutex_lock(&view_lock);
+  WindowMru* mru = ffi_mru;
+  g_mutex_unlock(&view_lock);
+  if (mru != nullptr) {
+    window_mru_activate(mru, GPOINTER_TO_SIZE(user_data));
+  }
+  return G_SOURCE_REMOVE;
+}
+
+void window_mru_ffi_end_cycle(gboolean activate) {
+  view_write_begin(&shared_view);
+  uint64_t xid =
+      ffi_mru != nullptr ? window_mru_view_clear_cursor(&shared_view) : 0;
+  view_write_end(&shared_view);
+  if (!activate || xid == 0) {
+    return;
+  }
+  if (g_main_context_is_owner(g_main_context_default())) {
+    activate_cb(GSIZE_TO_POINTER(xid));
+  } else {
+    // Called from the Dart UI thread: hand the X request to the GTK thread.
+    g_main_context_invoke(nullptr, activate_cb, GSIZE_TO_POINTER(xid));
+  }
+}
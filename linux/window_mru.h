@@ -0,0 +1,87 @@
+#ifndef FLUTTER_WINDOW_MRU_H_
+#define FLUTTER_WINDOW_MRU_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <gmodule.h>
+#include <gtk/gtk.h>
+
+#include <stdint.h>
+
+#include "window_mru_list.h"
+
+G_DECLARE_FINAL_TYPE(WindowMru, window_mru, WINDOW, MRU, GObject)
+
+/**
+ * window_mru_new:
+ * @window: the application #GtkWindow.
+ * @messenger: the #FlBinaryMessenger used for the "mru" channel.
+ *
+ * Creates a most-recently-used list of top-level windows, kept up to date
+ * from `_NET_ACTIVE_WINDOW`, `_NET_CLIENT_LIST` and focus changes of
+ * @window. Moving a window to the front and removing it are O(1).
+ *
+ * Returns: a new #WindowMru.
+ */
+WindowMru* window_mru_new(GtkWindow* window, FlBinaryMessenger* messenger);
+
+/**
+ * window_mru_cycle:
+ * @mru: a #WindowMru.
+ * @step: number of windows to move the switcher cursor by; positive values
+ * move towards less recently used windows. The cursor wraps around, so
+ * only @step modulo the number of windows matters.
+ *
+ * Moves the alt-tab cursor, starting a cycle at the most recently used
+ * window if none is in progress. Does not allocate.
+ *
+ * Returns: the X11 id of the selected window, or 0 if the list is empty.
+ */
+uint64_t window_mru_cycle(WindowMru* mru, int32_t step);
+
+/**
+ * window_mru_end_cycle:
+ * @mru: a #WindowMru.
+ * @activate: whether to ask the window manager to activate the selection.
+ *
+ * Ends the cycle started by window_mru_cycle().
+ */
+void window_mru_end_cycle(WindowMru* mru, gboolean activate);
+
+G_BEGIN_DECLS
+
+/**
+ * window_mru_get_view:
+ *
+ * FFI entry point returning the shared view of the current #WindowMru.
+ * The view stays valid for the life of the process and is empty while no
+ * list exists, so Dart may cache the pointer.
+ *
+ * Returns: (transfer none): the view.
+ */
+G_MODULE_EXPORT const WindowMruView* window_mru_get_view();
+
+/**
+ * window_mru_ffi_cycle:
+ * @step: see window_mru_cycle().
+ *
+ * FFI entry point calling window_mru_cycle() on the current #WindowMru, so
+ * the switcher can step on every key press without a platform message. May
+ * be called from the Dart UI thread.
+ *
+ * Returns: the X11 id of the selected window, or 0.
+ */
+G_MODULE_EXPORT uint64_t window_mru_ffi_cycle(int32_t step);
+
+/**
+ * window_mru_ffi_end_cycle:
+ * @activate: see window_mru_end_cycle().
+ *
+ * FFI entry point calling window_mru_end_cycle() on the current #WindowMru.
+ * May be called from the Dart UI thread; the activation request is then
+ * sent from the GTK thread.
+ */
+G_MODULE_EXPORT void window_mru_ffi_end_cycle(gboolean activate);
+
+G_END_DECLS
+
+#endif  // FLUTTER_WINDOW_MRU_H_
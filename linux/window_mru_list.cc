@@ -0,0 +1,190 @@
+#include "window_mru_list.h"
+
+namespace {
+
+void list_unlink(WindowMruView* view, int32_t slot) {
+  WindowMruSlot* entry = &view->slots[slot];
+  if (entry->prev >= 0) {
+    view->slots[entry->prev].next = entry->next;
+  } else {
+    view->head = entry->next;
+  }
+  if (entry->next >= 0) {
+    view->slots[entry->next].prev = entry->prev;
+  } else {
+    view->tail = entry->prev;
+  }
+  entry->prev = -1;
+  entry->next = -1;
+}
+
+void list_link_front(WindowMruView* view, int32_t slot) {
+  view->slots[slot].prev = -1;
+  view->slots[slot].next = view->head;
+  if (view->head >= 0) {
+    view->slots[view->head].prev = slot;
+  } else {
+    view->tail = slot;
+  }
+  view->head = slot;
+}
+
+void list_link_back(WindowMruView* view, int32_t slot) {
+  view->slots[slot].next = -1;
+  view->slots[slot].prev = view->tail;
+  if (view->tail >= 0) {
+    view->slots[view->tail].next = slot;
+  } else {
+    view->head = slot;
+  }
+  view->tail = slot;
+}
+
+void list_remove_slot(WindowMruList* list, int32_t slot) {
+  WindowMruView* view = list->view;
+  if (view->cursor == slot) {
+    view->cursor = view->slots[slot].next >= 0 ? view->slots[slot].next
+                                               : view->slots[slot].prev;
+  }
+  list_unlink(view, slot);
+  list->slots_by_xid->erase(view->slots[slot].xid);
+  view->slots[slot].xid = 0;
+  view->slots[slot].next = list->free_head;
+  list->free_head = slot;
+  view->count--;
+}
+
+// Adds a window that is not yet listed, evicting the least recently used one
+// if the list is full.
+int32_t list_insert(WindowMruList* list, uint64_t xid, bool front) {
+  WindowMruView* view = list->view;
+  if (list->free_head < 0) {
+    list_remove_slot(list, view->tail);
+  }
+  int32_t slot = list->free_head;
+  list->free_head = view->slots[slot].next;
+  view->slots[slot].xid = xid;
+  if (front) {
+    list_link_front(view, slot);
+  } else {
+    list_link_back(view, slot);
+  }
+  (*list->slots_by_xid)[xid] = slot;
+  (*list->marks)[slot] = list->generation;
+  view->count++;
+  return slot;
+}
+
+}  // namespace
+
+void window_mru_view_clear(WindowMruView* view) {
+  view->count = 0;
+  view->head = -1;
+  view->tail = -1;
+  view->cursor = -1;
+  for (int32_t slot = 0; slot < WINDOW_MRU_CAPACITY; slot++) {
+    view->slots[slot].xid = 0;
+    view->slots[slot].prev = -1;
+    view->slots[slot].next = slot + 1 < WINDOW_MRU_CAPACITY ? slot + 1 : -1;
+  }
+}
+
+uint64_t window_mru_view_cycle(WindowMruView* view, int32_t step) {
+  if (view->head < 0) {
+    return 0;
+  }
+  int32_t cursor = view->cursor >= 0 ? view->cursor : view->head;
+  // Walk at most half the list, whatever |step| Dart passed.
+  step %= view->count;
+  if (step > view->count / 2) {
+    step -= view->count;
+  } else if (step < -view->count / 2) {
+    step += view->count;
+  }
+  for (; step > 0; step--) {
+    cursor = view->slots[cursor].next >= 0 ? view->slots[cursor].next
+                                           : view->head;
+  }
+  for (; step < 0; step++) {
+    cursor = view->slots[cursor].prev >= 0 ? view->slots[cursor].prev
+                                           : view->tail;
+  }
+  view->cursor = cursor;
+  return view->slots[cursor].xid;
+}
+
+uint64_t window_mru_view_clear_cursor(WindowMruView* view) {
+  uint64_t xid = 0;
+  if (view->cursor >= 0) {
+    xid = view->slots[view->cursor].xid;
+    view->cursor = -1;
+  }
+  return xid;
+}
+
+void window_mru_list_init(WindowMruList* list, WindowMruView* view) {
+  list->view = view;
+  window_mru_view_clear(view);
+  list->slots_by_xid = new std::unordered_map<uint64_t, int32_t>();
+  list->slots_by_xid->reserve(WINDOW_MRU_CAPACITY);
+  list->free_head = 0;
+  list->generation = 0;
+  list->marks = new std::vector<uint32_t>(WINDOW_MRU_CAPACITY);
+}
+
+void window_mru_list_free(WindowMruList* list) {
+  delete list->slots_by_xid;
+  list->slots_by_xid = nullptr;
+  delete list->marks;
+  list->marks = nullptr;
+}
+
+int32_t window_mru_list_lookup(const WindowMruList* list, uint64_t xid) {
+  auto it = list->slots_by_xid->find(xid);
+  return it != list->slots_by_xid->end() ? it->second : -1;
+}
+
+bool window_mru_list_is_front(const WindowMruList* list, uint64_t xid) {
+  int32_t slot = window_mru_list_lookup(list, xid);
+  return slot >= 0 && slot == list->view->head;
+}
+
+void window_mru_list_touch(WindowMruList* list, uint64_t xid) {
+  int32_t slot = window_mru_list_lookup(list, xid);
+  if (slot >= 0) {
+    list_unlink(list->view, slot);
+    list_link_front(list->view, slot);
+  } else {
+    list_insert(list, xid, true);
+  }
+}
+
+void window_mru_list_add(WindowMruList* list, uint64_t xid, bool front) {
+  if (window_mru_list_lookup(list, xid) < 0) {
+    list_insert(list, xid, front);
+  }
+}
+
+void window_mru_list_begin_sync(WindowMruList* list) {
+  list->generation++;
+}
+
+void window_mru_list_mark(WindowMruList* list, uint64_t xid) {
+  int32_t slot = window_mru_list_lookup(list, xid);
+  if (slot >= 0) {
+    (*list->marks)[slot] = list->generation;
+  } else {
+    list_insert(list, xid, false);
+  }
+}
+
+void window_mru_list_end_sync(WindowMruList* list) {
+  WindowMruView* view = list->view;
+  for (int32_t slot = view->head; slot >= 0;) {
+    int32_t next = view->slots[slot].next;
+    if ((*list->marks)[slot] != list->generation) {
+      list_remove_slot(list, slot);
+    }
+    slot = next;
+  }
+}
@@ -0,0 +1,98 @@
+#ifndef FLUTTER_WINDOW_MRU_LIST_H_
+#define FLUTTER_WINDOW_MRU_LIST_H_
+
+#include <stdint.h>
+
+#include <unordered_map>
+#include <vector>
+
+// Number of windows tracked; the least recently used one is evicted beyond.
+#define WINDOW_MRU_CAPACITY 1024
+
+// One entry of the MRU list. Slots are linked by index so the list can be
+// reordered in place without moving entries.
+typedef struct {
+  // X11 window id, 0 for free slots.
+  uint64_t xid;
+  // Slot of the next more recently used window, -1 at the head.
+  int32_t prev;
+  // Slot of the next less recently used window, -1 at the tail.
+  int32_t next;
+} WindowMruSlot;
+
+// Read-only view of the MRU list shared with Dart through FFI. Its address
+// never changes. Writers bump |sequence| to an odd value before and back to
+// an even value after each update; readers copy what they need and retry if
+// |sequence| was odd or changed meanwhile.
+typedef struct {
+  int sequence;
+  int32_t count;
+  int32_t head;
+  int32_t tail;
+  // Slot highlighted by the switcher, -1 when not cycling.
+  int32_t cursor;
+  WindowMruSlot slots[WINDOW_MRU_CAPACITY];
+} WindowMruView;
+
+// Writer-side bookkeeping for a WindowMruView: the view holds the list in
+// most-recently-used order, this adds the lookup table and free list that
+// only the writer needs. It has no locking of its own; every function that
+// modifies the view must be called inside the owner's sequence bracket, see
+// WindowMruView. Zero-initialized storage must be set up with
+// window_mru_list_init().
+typedef struct {
+  WindowMruView* view;
+
+  // Maps X11 window ids to slots.
+  std::unordered_map<uint64_t, int32_t>* slots_by_xid;
+
+  // Free slots, linked through WindowMruSlot::next.
+  int32_t free_head;
+
+  // Generation counter and per-slot marks used to sweep windows that left
+  // `_NET_CLIENT_LIST` without allocating.
+  uint32_t generation;
+  std::vector<uint32_t>* marks;
+} WindowMruList;
+
+// Empties |view| and links every slot into its free list.
+void window_mru_view_clear(WindowMruView* view);
+
+// Moves the switcher cursor of |view| by |step| windows, starting at the
+// head if no cycle is in progress. Walks at most half the list whatever
+// |step| is. Returns the selected window, or 0 if the list is empty.
+uint64_t window_mru_view_cycle(WindowMruView* view, int32_t step);
+
+// Clears the switcher cursor of |view|. Returns the window it was on, or 0.
+uint64_t window_mru_view_clear_cursor(WindowMruView* view);
+
+// Sets up |list| to maintain |view|, which is cleared.
+void window_mru_list_init(WindowMruList* list, WindowMruView* view);
+
+// Releases what window_mru_list_init() allocated. The view is left as is.
+void window_mru_list_free(WindowMruList* list);
+
+// Returns the slot of |xid|, or -1 if it is not listed.
+int32_t window_mru_list_lookup(const WindowMruList* list, uint64_t xid);
+
+// Returns whether |xid| is the most recently used window.
+bool window_mru_list_is_front(const WindowMruList* list, uint64_t xid);
+
+// Moves |xid| to the front of the list, adding it if needed. Adding to a
+// full list evicts the least recently used window.
+void window_mru_list_touch(WindowMruList* list, uint64_t xid);
+
+// Adds |xid| at the front, or the back, unless it is already listed.
+void window_mru_list_add(WindowMruList* list, uint64_t xid, bool front);
+
+// Syncs the list with the set of managed windows: call
+// window_mru_list_begin_sync(), then window_mru_list_mark() for every
+// managed window, then window_mru_list_end_sync(). Windows not marked are
+// removed; marked windows not yet listed are appended as least recently
+// used. If the cursor's window is removed, the cursor moves to the next
+// less recently used one, or the previous one at the tail.
+void window_mru_list_begin_sync(WindowMruList* list);
+void window_mru_list_mark(WindowMruList* list, uint64_t xid);
+void window_mru_list_end_sync(WindowMruList* list);
+
+#endif  // FLUTTER_WINDOW_MRU_LIST_H_
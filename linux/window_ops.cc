@@ -0,0 +1,513 @@
+#include "window_ops.h"
+
+#ifdef GDK_WINDOWING_X11
+#include <gdk/gdkx.h>
+#endif
+#ifdef GDK_WINDOWING_WAYLAND
+#include <gdk/gdkwayland.h>
+#endif
+
+#include <cstring>
+
+#include "window_core/gtk_backend.h"
+
+namespace {
+
+constexpr char kChannelName[] = "function_window_drag/window_ops";
+
+struct EdgeName {
+  const char* name;
+  GdkWindowEdge edge;
+};
+
+const EdgeName kEdges[] = {
+    {"topLeft", GDK_WINDOW_EDGE_NORTH_WEST},
+    {"top", GDK_WINDOW_EDGE_NORTH},
+    {"topRight", GDK_WINDOW_EDGE_NORTH_EAST},
+    {"left", GDK_WINDOW_EDGE_WEST},
+    {"right", GDK_WINDOW_EDGE_EAST},
+    {"bottomLeft", GDK_WINDOW_EDGE_SOUTH_WEST},
+    {"bottom", GDK_WINDOW_EDGE_SOUTH},
+    {"bottomRight", GDK_WINDOW_EDGE_SOUTH_EAST},
+};
+
+// The most recent button press. Move and resize hand its implicit grab over
+// to the window manager or compositor.
+struct PressInfo {
+  GdkDevice* device;
+  guint button;
+  gdouble x_root;
+  gdouble y_root;
+  guint32 time;
+};
+
+}  // namespace
+
+// Operations that differ between windowing systems. Interactive moves and
+// resizes are left to GDK everywhere, see gdk_begin_drag().
+struct WindowOpsBackend {
+  const gchar* name;
+  // Adds the current window geometry to |geometry|.
+  void (*get_geometry)(WindowOps* self, FlValue* geometry);
+  // Whether geometry updates are coalesced to one per frame.
+  gboolean paced;
+  // Whether the client may position its own window, which snap drags need.
+  gboolean client_positioning;
+};
+
+struct _WindowOps {
+  GObject parent_instance;
+
+  // Window being operated on (weak reference).
+  GtkWindow* window;
+
+  FlMethodChannel* channel;
+
+  const WindowOpsBackend* backend;
+
+  guint press_signal_id;
+  gulong press_hook_id;
+  // Whether |press| holds a real press. Until then there is no grab to hand
+  // over and no pointer position to start from.
+  gboolean press_seen;
+  PressInfo press;
+
+  // Drives snap drags on backends with client positioning.
+  window_core::WindowCore<window_core::GtkBackend>* core;
+  guint motion_signal_id;
+  gulong motion_hook_id;
+  guint release_signal_id;
+  gulong release_hook_id;
+
+  // Frame clock pacing geometry updates on paced backends.
+  GdkFrameClock* frame_clock;
+  gboolean geometry_dirty;
+};
+
+G_DEFINE_TYPE(WindowOps, window_ops, G_TYPE_OBJECT)
+
+enum {
+  SIGNAL_GEOMETRY_CHANGED,
+  N_SIGNALS,
+};
+
+static guint signals[N_SIGNALS];
+
+G_DEFINE_QUARK(window-ops-error-quark, window_ops_error)
+
+static GdkDevice* window_ops_get_device(WindowOps* self) {
+  if (self->press.device != nullptr) {
+    return self->press.device;
+  }
+  GdkDisplay* display = gtk_widget_get_display(GTK_WIDGET(self->window));
+  return gdk_seat_get_pointer(gdk_display_get_default_seat(display));
+}
+
+// Starts an interactive move, or a resize from |edge| if |move| is FALSE,
+// and lets GDK drive it. On Wayland this issues xdg_toplevel.move and
+// xdg_toplevel.resize with the serial of the last press. On X11 GDK sends
+// `_NET_WM_MOVERESIZE` after releasing the press's implicit grab through
+// the device, which covers the XI2 grab GTK holds and keeps GDK's own grab
+// state right; without a supporting window manager it moves the window
+// itself.
+static void gdk_begin_drag(WindowOps* self, gboolean move,
+                           GdkWindowEdge edge) {
+  GdkWindow* gdk_window = gtk_widget_get_window(GTK_WIDGET(self->window));
+  GdkDevice* device = window_ops_get_device(self);
+  gint x_root = static_cast<gint>(self->press.x_root);
+  gint y_root = static_cast<gint>(self->press.y_root);
+  if (move) {
+    gdk_window_begin_move_drag_for_device(gdk_window, device,
+                                          self->press.button, x_root, y_root,
+                                          self->press.time);
+  } else {
+    gdk_window_begin_resize_drag_for_device(gdk_window, edge, device,
+                                            self->press.button, x_root,
+                                            y_root, self->press.time);
+  }
+}
+
+// Compositors do not reveal window positions, so only the size is known.
+static void gdk_get_geometry(WindowOps* self, FlValue* geometry) {
+  gint width = 0;
+  gint height = 0;
+  gtk_window_get_size(self->window, &width, &height);
+  fl_value_set_string_take(geometry, "x", fl_value_new_null());
+  fl_value_set_string_take(geometry, "y", fl_value_new_null());
+  fl_value_set_string_take(geometry, "width", fl_value_new_int(width));
+  fl_value_set_string_take(geometry, "height", fl_value_new_int(height));
+}
+
+#ifdef GDK_WINDOWING_X11
+static void x11_get_geometry(WindowOps* self, FlValue* geometry) {
+  GdkWindow* gdk_window = gtk_widget_get_window(GTK_WIDGET(self->window));
+  GdkRectangle frame;
+  gdk_window_get_frame_extents(gdk_window, &frame);
+  fl_value_set_string_take(geometry, "x", fl_value_new_int(frame.x));
+  fl_value_set_string_take(geometry, "y", fl_value_new_int(frame.y));
+  fl_value_set_string_take(geometry, "width", fl_value_new_int(frame.width));
+  fl_value_set_string_take(geometry, "height", fl_value_new_int(frame.height));
+}
+
+const WindowOpsBackend kX11Backend = {"x11", x11_get_geometry, FALSE, TRUE};
+#endif
+
+const WindowOpsBackend kWaylandBackend = {"wayland", gdk_get_geometry, TRUE,
+                                          FALSE};
+
+// Used for any other GDK backend (e.g. Broadway).
+const WindowOpsBackend kGdkBackend = {"gdk", gdk_get_geometry, TRUE, FALSE};
+
+FlValue* window_ops_get_geometry(WindowOps* self) {
+  g_return_val_if_fail(WINDOW_IS_OPS(self), nullptr);
+
+  FlValue* geometry = fl_value_new_map();
+  fl_value_set_string_take(geometry, "backend",
+                           fl_value_new_string(self->backend->name));
+  self->backend->get_geometry(self, geometry);
+  return geometry;
+}
+
+static void window_ops_post_geometry(WindowOps* self) {
+  self->geometry_dirty = FALSE;
+  g_signal_emit(self, signals[SIGNAL_GEOMETRY_CHANGED], 0);
+  if (self->channel == nullptr) {
+    return;
+  }
+  g_autoptr(FlValue) geometry = window_ops_get_geometry(self);
+  fl_method_channel_invoke_method(self->channel, "onGeometryChanged", geometry,
+                                  nullptr, nullptr, nullptr);
+}
+
+static gboolean press_hook(GSignalInvocationHint* hint, guint n_param_values,
+                           const GValue* param_values, gpointer user_data) {
+  WindowOps* self = WINDOW_OPS(user_data);
+  GdkEvent* event = static_cast<GdkEvent*>(g_value_get_boxed(&param_values[1]));
+  if (event != nullptr && event->type == GDK_BUTTON_PRESS) {
+    self->press.device = gdk_event_get_device(event);
+    self->press.button = event->button.button;
+    self->press.x_root = event->button.x_root;
+    self->press.y_root = event->button.y_root;
+    self->press.time = event->button.time;
+    self->press_seen = TRUE;
+  }
+  return TRUE;
+}
+
+static gboolean configure_cb(GtkWidget* widget, GdkEventConfigure* event,
+                             gpointer user_data) {
+  WindowOps* self = WINDOW_OPS(user_data);
+  if (self->backend->paced && self->frame_clock != nullptr) {
+    self->geometry_dirty = TRUE;
+    gdk_frame_clock_request_phase(self->frame_clock,
+                                  GDK_FRAME_CLOCK_PHASE_AFTER_PAINT);
+  } else {
+    window_ops_post_geometry(self);
+  }
+  return FALSE;
+}
+
+// On Wayland the frame clock is driven by wl_surface frame callbacks, so
+// this runs at most once per presented frame.
+static void after_paint_cb(GdkFrameClock* frame_clock, gpointer user_data) {
+  WindowOps* self = WINDOW_OPS(user_data);
+  if (self->geometry_dirty && self->window != nullptr) {
+    window_ops_post_geometry(self);
+  }
+}
+
+static const gchar* snap_zone_name(window_core::SnapZone zone) {
+  switch (zone) {
+    case window_core::SnapZone::kLeftHalf:
+      return "leftHalf";
+    case window_core::SnapZone::kRightHalf:
+      return "rightHalf";
+    case window_core::SnapZone::kMaximize:
+      return "maximize";
+    case window_core::SnapZone::kNone:
+      break;
+  }
+  return "none";
+}
+
+// Follows the pointer during a snap drag. Returning FALSE removes the hook
+// once the drag is over.
+static gboolean snap_motion_hook(GSignalInvocationHint* hint,
+                                 guint n_param_values,
+                                 const GValue* param_values,
+                                 gpointer user_data) {
+  WindowOps* self = WINDOW_OPS(user_data);
+  if (self->window == nullptr || !self->core->dragging()) {
+    self->motion_hook_id = 0;
+    return FALSE;
+  }
+  GdkEvent* event = static_cast<GdkEvent*>(g_value_get_boxed(&param_values[1]));
+  if (event != nullptr && event->type == GDK_MOTION_NOTIFY) {
+    self->core->UpdateDrag(static_cast<int>(event->motion.x_root),
+                           static_cast<int>(event->motion.y_root));
+  }
+  return TRUE;
+}
+
+static gboolean snap_release_hook(GSignalInvocationHint* hint,
+                                  guint n_param_values,
+                                  const GValue* param_values,
+                                  gpointer user_data) {
+  WindowOps* self = WINDOW_OPS(user_data);
+  if (self->window == nullptr) {
+    self->release_hook_id = 0;
+    return FALSE;
+  }
+  GdkEvent* event = static_cast<GdkEvent*>(g_value_get_boxed(&param_values[1]));
+  if (event == nullptr || event->type != GDK_BUTTON_RELEASE ||
+      event->button.button != self->press.button) {
+    return TRUE;
+  }
+
+  window_core::SnapZone zone = self->core->EndDrag();
+  self->release_hook_id = 0;
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "zone",
+                           fl_value_new_string(snap_zone_name(zone)));
+  if (self->channel == nullptr) {
+    return FALSE;
+  }
+  fl_method_channel_invoke_method(self->channel, "onSnapDragEnd", result,
+                                  nullptr, nullptr, nullptr);
+  return FALSE;
+}
+
+// Moves the window natively while the pressed button is held, snapping it
+// to work area edges and applying a half or maximized layout on release.
+// Where clients cannot position windows this is a plain compositor move.
+static void window_ops_start_snap_drag(WindowOps* self) {
+  if (self->core == nullptr) {
+    gdk_begin_drag(self, TRUE, GDK_WINDOW_EDGE_NORTH_WEST);
+    return;
+  }
+  if (self->core->dragging()) {
+    return;
+  }
+  self->core->BeginDrag(static_cast<int>(self->press.x_root),
+                        static_cast<int>(self->press.y_root));
+  if (self->motion_hook_id == 0) {
+    self->motion_hook_id = g_signal_add_emission_hook(
+        self->motion_signal_id, 0, snap_motion_hook, self, nullptr);
+  }
+  if (self->release_hook_id == 0) {
+    self->release_hook_id = g_signal_add_emission_hook(
+        self->release_signal_id, 0, snap_release_hook, self, nullptr);
+  }
+}
+
+// Fails unless a press has been seen whose grab a drag can take over.
+static gboolean window_ops_check_press(WindowOps* self, GError** error) {
+  if (self->window == nullptr) {
+    g_set_error(error, WINDOW_OPS_ERROR, WINDOW_OPS_ERROR_NO_WINDOW,
+                "The application window is gone");
+    return FALSE;
+  }
+  if (!self->press_seen) {
+    g_set_error(error, WINDOW_OPS_ERROR, WINDOW_OPS_ERROR_NO_PRESS,
+                "No button press has been seen to start the drag from");
+    return FALSE;
+  }
+  return TRUE;
+}
+
+gboolean window_ops_begin_move(WindowOps* self, GError** error) {
+  g_return_val_if_fail(WINDOW_IS_OPS(self), FALSE);
+
+  if (!window_ops_check_press(self, error)) {
+    return FALSE;
+  }
+  gdk_begin_drag(self, TRUE, GDK_WINDOW_EDGE_NORTH_WEST);
+  return TRUE;
+}
+
+gboolean window_ops_begin_snap_drag(WindowOps* self, GError** error) {
+  g_return_val_if_fail(WINDOW_IS_OPS(self), FALSE);
+
+  if (!window_ops_check_press(self, error)) {
+    return FALSE;
+  }
+  window_ops_start_snap_drag(self);
+  return TRUE;
+}
+
+gboolean window_ops_begin_resize(WindowOps* self, GdkWindowEdge edge,
+                                 GError** error) {
+  g_return_val_if_fail(WINDOW_IS_OPS(self), FALSE);
+
+  if (!window_ops_check_press(self, error)) {
+    return FALSE;
+  }
+  gdk_begin_drag(self, FALSE, edge);
+  return TRUE;
+}
+
+const gchar* window_ops_get_backend_name(WindowOps* self) {
+  g_return_val_if_fail(WINDOW_IS_OPS(self), nullptr);
+  return self->backend->name;
+}
+
+static FlMethodResponse* error_response(GError* error) {
+  const gchar* code =
+      error->code == WINDOW_OPS_ERROR_NO_PRESS ? "no_press" : "no_window";
+  return FL_METHOD_RESPONSE(
+      fl_method_error_response_new(code, error->message, nullptr));
+}
+
+static FlMethodResponse* begin_resize_method(WindowOps* self, FlValue* args) {
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_STRING) {
+    for (const EdgeName& edge : kEdges) {
+      if (strcmp(fl_value_get_string(args), edge.name) == 0) {
+        g_autoptr(GError) error = nullptr;
+        if (!window_ops_begin_resize(self, edge.edge, &error)) {
+          return error_response(error);
+        }
+        return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+      }
+    }
+  }
+  return FL_METHOD_RESPONSE(fl_method_error_response_new(
+      "bad_args", "Expected a window edge name", nullptr));
+}
+
+static void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
+                           gpointer user_data) {
+  WindowOps* self = WINDOW_OPS(user_data);
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  g_autoptr(GError) begin_error = nullptr;
+  if (self->window == nullptr) {
+    response = FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "no_window", "The application window is gone", nullptr));
+  } else if (strcmp(method, "beginMove") == 0) {
+    response =
+        window_ops_begin_move(self, &begin_error)
+            ? FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr))
+            : error_response(begin_error);
+  } else if (strcmp(method, "beginSnapDrag") == 0) {
+    response =
+        window_ops_begin_snap_drag(self, &begin_error)
+            ? FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr))
+            : error_response(begin_error);
+  } else if (strcmp(method, "beginResize") == 0) {
+    response = begin_resize_method(self, args);
+  } else if (strcmp(method, "getGeometry") == 0) {
+    g_autoptr(FlValue) geometry = window_ops_get_geometry(self);
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(geometry));
+  } else {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error)) {
+    g_warning("Failed to send window operation response: %s", error->message);
+  }
+}
+
+// Implements GObject::dispose.
+static void window_ops_dispose(GObject* object) {
+  WindowOps* self = WINDOW_OPS(object);
+
+  if (self->press_hook_id != 0) {
+    g_signal_remove_emission_hook(self->press_signal_id, self->press_hook_id);
+    self->press_hook_id = 0;
+  }
+  if (self->motion_hook_id != 0) {
+    g_signal_remove_emission_hook(self->motion_signal_id,
+                                  self->motion_hook_id);
+    self->motion_hook_id = 0;
+  }
+  if (self->release_hook_id != 0) {
+    g_signal_remove_emission_hook(self->release_signal_id,
+                                  self->release_hook_id);
+    self->release_hook_id = 0;
+  }
+  delete self->core;
+  self->core = nullptr;
+  if (self->frame_clock != nullptr) {
+    g_signal_handlers_disconnect_by_data(self->frame_clock, self);
+    g_clear_object(&self->frame_clock);
+  }
+  if (self->window != nullptr) {
+    g_signal_handlers_disconnect_by_data(self->window, self);
+    g_object_remove_weak_pointer(G_OBJECT(self->window),
+                                 reinterpret_cast<gpointer*>(&self->window));
+    self->window = nullptr;
+  }
+  g_clear_object(&self->channel);
+
+  G_OBJECT_CLASS(window_ops_parent_class)->dispose(object);
+}
+
+static void window_ops_class_init(WindowOpsClass* klass) {
+  G_OBJECT_CLASS(klass)->dispose = window_ops_dispose;
+
+  signals[SIGNAL_GEOMETRY_CHANGED] =
+      g_signal_new("geometry-changed", window_ops_get_type(), G_SIGNAL_RUN_LAST,
+                   0, nullptr, nullptr, nullptr, G_TYPE_NONE, 0);
+}
+
+static void window_ops_init(WindowOps* self) {
+  self->backend = &kGdkBackend;
+}
+
+WindowOps* window_ops_new(GtkWindow* window, FlBinaryMessenger* messenger) {
+  WindowOps* self = WINDOW_OPS(g_object_new(window_ops_get_type(), nullptr));
+
+  self->window = window;
+  g_object_add_weak_pointer(G_OBJECT(window),
+                            reinterpret_cast<gpointer*>(&self->window));
+
+  GdkDisplay* display = gtk_widget_get_display(GTK_WIDGET(window));
+#ifdef GDK_WINDOWING_X11
+  if (GDK_IS_X11_DISPLAY(display)) {
+    self->backend = &kX11Backend;
+  }
+#endif
+#ifdef GDK_WINDOWING_WAYLAND
+  if (GDK_IS_WAYLAND_DISPLAY(display)) {
+    self->backend = &kWaylandBackend;
+  }
+#endif
+
+  // Presses are usually consumed by the Flutter view, so watch them with an
+  // emission hook rather than a handler on the window.
+  self->press_signal_id =
+      g_signal_lookup("button-press-event", GTK_TYPE_WIDGET);
+  self->press_hook_id = g_signal_add_emission_hook(
+      self->press_signal_id, 0, press_hook, self, nullptr);
+
+  self->motion_signal_id =
+      g_signal_lookup("motion-notify-event", GTK_TYPE_WIDGET);
+  self->release_signal_id =
+      g_signal_lookup("button-release-event", GTK_TYPE_WIDGET);
+  if (self->backend->client_positioning) {
+    self->core = new window_core::WindowCore<window_core::GtkBackend>(
+        window_core::GtkBackend(window));
+  }
+
+  g_signal_connect(window, "configure-event", G_CALLBACK(configure_cb), self);
+  GdkFrameClock* frame_clock = gtk_widget_get_frame_clock(GTK_WIDGET(window));
+  if (self->backend->paced && frame_clock != nullptr) {
+    self->frame_clock = GDK_FRAME_CLOCK(g_object_ref(frame_clock));
+    g_signal_connect(frame_clock, "after-paint", G_CALLBACK(after_paint_cb),
+                     self);
+  }
+
+  if (messenger == nullptr) {
+    return self;
+  }
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  self->channel = fl_method_channel_new(messenger, kChannelName,
+                                        FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(self->channel, method_call_cb,
+                                            self, nullptr);
+
+  return self;
+}
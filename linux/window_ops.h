@@ -0,0 +1,101 @@
+#ifndef FLUTTER_WINDOW_OPS_H_
+#define FLUTTER_WINDOW_OPS_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <gtk/gtk.h>
+
+G_DECLARE_FINAL_TYPE(WindowOps, window_ops, WINDOW, OPS, GObject)
+
+#define WINDOW_OPS_ERROR window_ops_error_quark()
+
+typedef enum {
+  WINDOW_OPS_ERROR_NO_WINDOW,
+  WINDOW_OPS_ERROR_NO_PRESS,
+} WindowOpsError;
+
+GQuark window_ops_error_quark();
+
+/**
+ * window_ops_new:
+ * @window: the #GtkWindow to operate on.
+ * @messenger: (allow-none): the #FlBinaryMessenger used for the
+ *   "window_ops" channel, or %NULL to only drive the operations from native
+ *   code.
+ *
+ * Creates the native window operations used by Dart: interactive move and
+ * resize and geometry tracking. The backend is picked at runtime from the
+ * display type. On X11 moves and resizes are handed to the window manager
+ * with `_NET_WM_MOVERESIZE` and geometry is reported on every configure.
+ * On Wayland they map to `xdg_toplevel.move` and `xdg_toplevel.resize`, and
+ * geometry updates are coalesced to one per frame callback. Each update is
+ * sent to Dart as "onGeometryChanged" and emitted as the
+ * #WindowOps::geometry-changed signal.
+ *
+ * Snap drags, which move the window natively and snap it to work area edges
+ * using the portable window core, need client positioning and degrade to a
+ * plain compositor move on Wayland.
+ *
+ * Moves, snap drags and resizes take over the grab of the last button press
+ * on any widget, so Dart must call them from a pointer-down handler. They
+ * fail with a "no_press" error if no press has been seen yet.
+ *
+ * Returns: a new #WindowOps.
+ */
+WindowOps* window_ops_new(GtkWindow* window, FlBinaryMessenger* messenger);
+
+/**
+ * window_ops_get_backend_name:
+ * @ops: a #WindowOps.
+ *
+ * Returns: the backend picked for the display: "x11", "wayland" or "gdk".
+ */
+const gchar* window_ops_get_backend_name(WindowOps* ops);
+
+/**
+ * window_ops_get_geometry:
+ * @ops: a #WindowOps.
+ *
+ * Returns: (transfer full): a map with the backend name and the window's
+ * "x", "y", "width" and "height", as sent with "onGeometryChanged".
+ */
+FlValue* window_ops_get_geometry(WindowOps* ops);
+
+/**
+ * window_ops_begin_move:
+ * @ops: a #WindowOps.
+ * @error: (allow-none): #GError location to store the error occurring, or
+ *   %NULL to ignore.
+ *
+ * Hands the last button press over to an interactive move.
+ *
+ * Returns: %TRUE if the move was started.
+ */
+gboolean window_ops_begin_move(WindowOps* ops, GError** error);
+
+/**
+ * window_ops_begin_snap_drag:
+ * @ops: a #WindowOps.
+ * @error: (allow-none): #GError location to store the error occurring, or
+ *   %NULL to ignore.
+ *
+ * Starts a snap drag from the last button press.
+ *
+ * Returns: %TRUE if the drag was started.
+ */
+gboolean window_ops_begin_snap_drag(WindowOps* ops, GError** error);
+
+/**
+ * window_ops_begin_resize:
+ * @ops: a #WindowOps.
+ * @edge: the edge or corner to resize from.
+ * @error: (allow-none): #GError location to store the error occurring, or
+ *   %NULL to ignore.
+ *
+ * Hands the last button press over to an interactive resize.
+ *
+ * Returns: %TRUE if the resize was started.
+ */
+gboolean window_ops_begin_resize(WindowOps* ops, GdkWindowEdge edge,
+                                 GError** error);
+
+#endif  // FLUTTER_WINDOW_OPS_H_